@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <regex>
@@ -44,6 +45,8 @@
 #include "core/movie.h"
 #include "core/settings.h"
 #include "network/network.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
 
 #ifdef _WIN32
 extern "C" {
@@ -399,6 +402,9 @@ int main(int argc, char** argv) {
         Core::Movie::GetInstance().StartRecording(movie_record);
     }
 
+    std::atomic_bool stop_run{false};
+    VideoCore::g_renderer->Rasterizer()->LoadDiskResources(stop_run, {});
+
     while (emu_window->IsOpen()) {
         system.RunLoop();
     }
@@ -120,6 +120,10 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", false);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_disk_shader_cache =
+        sdl2_config->GetBoolean("Renderer", "use_disk_shader_cache", true);
+    Settings::values.use_async_shader_compilation =
+        sdl2_config->GetBoolean("Renderer", "use_async_shader_compilation", false);
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
     Settings::values.vsync_enabled = sdl2_config->GetBoolean("Renderer", "vsync_enabled", false);
@@ -175,6 +179,14 @@ void Config::ReadValues() {
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.cache_decrypted_content =
+        sdl2_config->GetBoolean("Data Storage", "cache_decrypted_content", false);
+    Settings::values.romfs_cache_size =
+        static_cast<u32>(sdl2_config->GetInteger("Data Storage", "romfs_cache_size", 2));
+    Settings::values.save_data_sync = static_cast<Settings::SaveDataSync>(
+        sdl2_config->GetInteger("Data Storage", "save_data_sync", 0));
+    Settings::values.verify_content = static_cast<Settings::ContentVerification>(
+        sdl2_config->GetInteger("Data Storage", "verify_content", 0));
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", false);
@@ -116,6 +116,15 @@ shaders_accurate_gs =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to store generated shaders on disk and build them at boot, reducing stutter
+# 0: Off, 1 (default): On
+use_disk_shader_cache =
+
+# Whether to build new fragment shaders on a background thread. Draws are skipped until the shader
+# is ready, which avoids stutter at the cost of briefly missing geometry
+# 0 (default): Off, 1: On
+use_async_shader_compilation =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
@@ -205,6 +214,27 @@ volume =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Whether to keep a decrypted copy of the ExeFS sections and RomFS of encrypted titles in the cache
+# directory, so that later boots do not decrypt them again. The first boot writes the whole RomFS.
+# The decompressed code of every title is also kept.
+# 0 (default): No, 1: Yes
+cache_decrypted_content =
+
+# Memory used by each encrypted RomFS to keep its most recently read blocks decrypted, in MiB
+# 0: Disabled, 2 (default), otherwise the size of the cache
+romfs_cache_size =
+
+# When the save data written by titles is synced to the storage device. Writes are buffered and
+# reach the save files when they are flushed or closed, or at the latest after a second.
+# 0 (default): Left to the OS, 1: When a save file is closed, 2: Whenever save data is written out
+save_data_sync =
+
+# Whether to check the ExeFS and RomFS of the booted title against their hashes, to find bad dumps.
+# The result is logged. Checking reads the whole title, on one CPU core in the background, or on all
+# of them before booting.
+# 0 (default): No, 1: In the background after booting, 2: Before booting
+verify_content =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS (default), 1: New 3DS
@@ -20,6 +20,29 @@
 #include "input_common/sdl/sdl.h"
 #include "network/network.h"
 
+class SharedContext_SDL2 : public GraphicsContext {
+public:
+    SharedContext_SDL2(SDL_Window* window, SDL_GLContext context)
+        : window(window), context(context) {}
+
+    ~SharedContext_SDL2() override {
+        SDL_GL_DeleteContext(context);
+        SDL_DestroyWindow(window);
+    }
+
+    void MakeCurrent() override {
+        SDL_GL_MakeCurrent(window, context);
+    }
+
+    void DoneCurrent() override {
+        SDL_GL_MakeCurrent(window, nullptr);
+    }
+
+private:
+    SDL_Window* window;
+    SDL_GLContext context;
+};
+
 void EmuWindow_SDL2::OnMouseMotion(s32 x, s32 y) {
     TouchMoved((unsigned)std::max(x, 0), (unsigned)std::max(y, 0));
     InputCommon::GetMotionEmu()->Tilt(x, y);
@@ -252,6 +275,29 @@ void EmuWindow_SDL2::DoneCurrent() {
     SDL_GL_MakeCurrent(render_window, nullptr);
 }
 
+std::unique_ptr<GraphicsContext> EmuWindow_SDL2::CreateSharedContext() {
+    // The context needs a drawable of its own, so that it can be current on another thread
+    SDL_Window* window = SDL_CreateWindow("", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1,
+                                          1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (window == nullptr) {
+        LOG_ERROR(Frontend, "Failed to create SDL2 window for shared context: {}", SDL_GetError());
+        return nullptr;
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    SDL_GLContext context = SDL_GL_CreateContext(window);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    if (context == nullptr) {
+        LOG_ERROR(Frontend, "Failed to create SDL2 shared GL context: {}", SDL_GetError());
+        SDL_DestroyWindow(window);
+        return nullptr;
+    }
+
+    // Creating the context made it current, give the caller thread its context back
+    MakeCurrent();
+    return std::make_unique<SharedContext_SDL2>(window, context);
+}
+
 void EmuWindow_SDL2::OnMinimalClientAreaChangeRequest(
     const std::pair<unsigned, unsigned>& minimal_size) {
 
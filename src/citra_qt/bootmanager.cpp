@@ -1,6 +1,8 @@
 #include <QApplication>
 #include <QHBoxLayout>
 #include <QKeyEvent>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
 #include <QScreen>
 #include <QWindow>
 #include <fmt/format.h>
@@ -15,6 +17,7 @@
 #include "input_common/main.h"
 #include "input_common/motion_emu.h"
 #include "network/network.h"
+#include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
 EmuThread::EmuThread(GRenderWindow* render_window) : render_window(render_window) {}
@@ -24,6 +27,11 @@ void EmuThread::run() {
 
     MicroProfileOnThreadCreate("EmuThread");
 
+    VideoCore::g_renderer->Rasterizer()->LoadDiskResources(
+        stop_run, [this](VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total) {
+            emit LoadProgress(stage, value, total);
+        });
+
     // Holds whether the cpu was running during the last iteration,
     // so that the DebugModeLeft signal can be emitted before the
     // next execution step.
@@ -152,6 +160,58 @@ void GRenderWindow::DoneCurrent() {
 
 void GRenderWindow::PollEvents() {}
 
+/// A QOpenGLContext sharing objects with the context of the render window, for worker threads
+class GGLContext : public GraphicsContext {
+public:
+    explicit GGLContext(QOpenGLContext* shared_context)
+        : context(std::make_unique<QOpenGLContext>()),
+          surface(std::make_unique<QOffscreenSurface>()) {
+        context->setShareContext(shared_context);
+        context->setFormat(shared_context->format());
+        context->create();
+        surface->setFormat(shared_context->format());
+        surface->create();
+
+        // Qt only allows making a context current on the thread it belongs to. A context without
+        // thread affinity can be pulled by the first thread that uses it.
+        context->moveToThread(nullptr);
+    }
+
+    ~GGLContext() override {
+        context.reset();
+        // The context is released on the emulation thread, but the surface has to be destroyed on
+        // the GUI thread it was created on
+        surface.release()->deleteLater();
+    }
+
+    bool IsValid() const {
+        return context->isValid() && surface->isValid();
+    }
+
+    void MakeCurrent() override {
+        if (context->thread() != QThread::currentThread())
+            context->moveToThread(QThread::currentThread());
+        context->makeCurrent(surface.get());
+    }
+
+    void DoneCurrent() override {
+        context->doneCurrent();
+    }
+
+private:
+    std::unique_ptr<QOpenGLContext> context;
+    std::unique_ptr<QOffscreenSurface> surface;
+};
+
+std::unique_ptr<GraphicsContext> GRenderWindow::CreateSharedContext() {
+    auto context = std::make_unique<GGLContext>(child->context()->contextHandle());
+    if (!context->IsValid()) {
+        LOG_ERROR(Frontend, "Failed to create shared GL context");
+        return nullptr;
+    }
+    return context;
+}
+
 // On Qt 5.0+, this correctly gets the size of the framebuffer (pixels).
 //
 // Older versions get the window size (density independent pixels),
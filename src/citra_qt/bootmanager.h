@@ -13,6 +13,7 @@
 #include "common/thread.h"
 #include "core/core.h"
 #include "core/frontend/emu_window.h"
+#include "video_core/rasterizer_interface.h"
 
 class QKeyEvent;
 class QScreen;
@@ -101,6 +102,9 @@ signals:
     void DebugModeLeft();
 
     void ErrorThrown(Core::System::ResultStatus, std::string);
+
+    /// Emitted while the resources cached on disk are loaded, before emulation starts
+    void LoadProgress(VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total);
 };
 
 class GRenderWindow : public QWidget, public EmuWindow {
@@ -115,6 +119,7 @@ public:
     void MakeCurrent() override;
     void DoneCurrent() override;
     void PollEvents() override;
+    std::unique_ptr<GraphicsContext> CreateSharedContext() override;
 
     void BackupGeometry();
     void RestoreGeometry();
@@ -160,6 +160,9 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_gs = ReadSetting("shaders_accurate_gs", true).toBool();
     Settings::values.shaders_accurate_mul = ReadSetting("shaders_accurate_mul", false).toBool();
     Settings::values.use_shader_jit = ReadSetting("use_shader_jit", true).toBool();
+    Settings::values.use_disk_shader_cache = ReadSetting("use_disk_shader_cache", true).toBool();
+    Settings::values.use_async_shader_compilation =
+        ReadSetting("use_async_shader_compilation", false).toBool();
     Settings::values.resolution_factor =
         static_cast<u16>(ReadSetting("resolution_factor", 1).toInt());
     Settings::values.vsync_enabled = ReadSetting("vsync_enabled", false).toBool();
@@ -227,6 +230,13 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Data Storage");
     Settings::values.use_virtual_sd = ReadSetting("use_virtual_sd", true).toBool();
+    Settings::values.cache_decrypted_content =
+        ReadSetting("cache_decrypted_content", false).toBool();
+    Settings::values.romfs_cache_size = ReadSetting("romfs_cache_size", 2).toUInt();
+    Settings::values.save_data_sync =
+        static_cast<Settings::SaveDataSync>(ReadSetting("save_data_sync", 0).toInt());
+    Settings::values.verify_content =
+        static_cast<Settings::ContentVerification>(ReadSetting("verify_content", 0).toInt());
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -450,6 +460,9 @@ void Config::SaveValues() {
     WriteSetting("shaders_accurate_gs", Settings::values.shaders_accurate_gs, true);
     WriteSetting("shaders_accurate_mul", Settings::values.shaders_accurate_mul, false);
     WriteSetting("use_shader_jit", Settings::values.use_shader_jit, true);
+    WriteSetting("use_disk_shader_cache", Settings::values.use_disk_shader_cache, true);
+    WriteSetting("use_async_shader_compilation", Settings::values.use_async_shader_compilation,
+                 false);
     WriteSetting("resolution_factor", Settings::values.resolution_factor, 1);
     WriteSetting("vsync_enabled", Settings::values.vsync_enabled, false);
     WriteSetting("use_frame_limit", Settings::values.use_frame_limit, true);
@@ -510,6 +523,10 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Data Storage");
     WriteSetting("use_virtual_sd", Settings::values.use_virtual_sd, true);
+    WriteSetting("cache_decrypted_content", Settings::values.cache_decrypted_content, false);
+    WriteSetting("romfs_cache_size", Settings::values.romfs_cache_size, 2);
+    WriteSetting("save_data_sync", static_cast<int>(Settings::values.save_data_sync), 0);
+    WriteSetting("verify_content", static_cast<int>(Settings::values.verify_content), 0);
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
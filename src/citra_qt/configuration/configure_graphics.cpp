@@ -61,6 +61,8 @@ void ConfigureGraphics::setConfiguration() {
     ui->toggle_accurate_gs->setChecked(Settings::values.shaders_accurate_gs);
     ui->toggle_accurate_mul->setChecked(Settings::values.shaders_accurate_mul);
     ui->toggle_shader_jit->setChecked(Settings::values.use_shader_jit);
+    ui->toggle_disk_shader_cache->setChecked(Settings::values.use_disk_shader_cache);
+    ui->toggle_async_shaders->setChecked(Settings::values.use_async_shader_compilation);
     ui->resolution_factor_combobox->setCurrentIndex(Settings::values.resolution_factor);
     ui->toggle_frame_limit->setChecked(Settings::values.use_frame_limit);
     ui->frame_limit->setValue(Settings::values.frame_limit);
@@ -82,6 +84,8 @@ void ConfigureGraphics::applyConfiguration() {
     Settings::values.shaders_accurate_gs = ui->toggle_accurate_gs->isChecked();
     Settings::values.shaders_accurate_mul = ui->toggle_accurate_mul->isChecked();
     Settings::values.use_shader_jit = ui->toggle_shader_jit->isChecked();
+    Settings::values.use_disk_shader_cache = ui->toggle_disk_shader_cache->isChecked();
+    Settings::values.use_async_shader_compilation = ui->toggle_async_shaders->isChecked();
     Settings::values.resolution_factor =
         static_cast<u16>(ui->resolution_factor_combobox->currentIndex());
     Settings::values.use_frame_limit = ui->toggle_frame_limit->isChecked();
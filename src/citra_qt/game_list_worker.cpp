@@ -2,12 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 #include "citra_qt/compatibility_list.h"
 #include "citra_qt/game_list.h"
 #include "citra_qt/game_list_p.h"
@@ -15,6 +22,7 @@
 #include "citra_qt/ui_settings.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/logging/log.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/loader/loader.h"
@@ -24,6 +32,14 @@ bool HasSupportedFileExtension(const std::string& file_name) {
     const QFileInfo file = QFileInfo(QString::fromStdString(file_name));
     return GameList::supported_file_extensions.contains(file.suffix(), Qt::CaseInsensitive);
 }
+
+// Bump when the layout of the cache file or the information read from the files changes
+constexpr quint32 METADATA_CACHE_VERSION = 1;
+
+QString GetMetadataCachePath() {
+    return QString::fromStdString(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir)) +
+           "game_list.bin";
+}
 } // Anonymous namespace
 
 GameListWorker::GameListWorker(QList<UISettings::GameDir>& game_dirs,
@@ -45,76 +61,180 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
         const std::string physical_name = directory + DIR_SEP + virtual_name;
         const bool is_dir = FileUtil::IsDirectory(physical_name);
         if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
-            if (!loader)
-                return true;
+            game_files.push_back({physical_name, parent_dir});
+        } else if (is_dir && recursion > 0) {
+            watch_list.append(QString::fromStdString(physical_name));
+            AddFstEntriesToGameList(physical_name, recursion - 1, parent_dir);
+        }
+
+        return true;
+    };
 
-            u64 program_id = 0;
-            loader->ReadProgramId(program_id);
+    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+}
 
-            u64 extdata_id = 0;
-            loader->ReadExtdataId(extdata_id);
+void GameListWorker::AddEntries() {
+    // Opening the files is mostly spent waiting for the disk and decrypting, so every file is
+    // handled by the first free thread
+    std::atomic<std::size_t> next_file{0};
+    const auto work = [this, &next_file] {
+        for (std::size_t i = next_file++; i < game_files.size() && !stop_processing;
+             i = next_file++) {
+            AddEntry(game_files[i]);
+        }
+    };
 
-            std::vector<u8> smdh = [program_id, &loader]() -> std::vector<u8> {
-                std::vector<u8> original_smdh;
-                loader->ReadIcon(original_smdh);
+    const unsigned num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < num_threads; ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
 
-                if (program_id < 0x0004000000000000 || program_id > 0x00040000FFFFFFFF)
-                    return original_smdh;
+void GameListWorker::AddEntry(const GameFile& game_file) {
+    const std::optional<Metadata> metadata = ReadMetadata(game_file.path);
+    if (!metadata)
+        return;
 
-                std::string update_path = Service::AM::GetTitleContentPath(
-                    Service::FS::MediaType::SDMC, program_id + 0x0000000E00000000);
+    const u64 program_id = metadata->program_id;
+    std::vector<u8> smdh = [this, program_id, &metadata]() -> std::vector<u8> {
+        if (program_id < 0x0004000000000000 || program_id > 0x00040000FFFFFFFF)
+            return metadata->smdh;
 
-                if (!FileUtil::Exists(update_path))
-                    return original_smdh;
+        std::string update_path = Service::AM::GetTitleContentPath(
+            Service::FS::MediaType::SDMC, program_id + 0x0000000E00000000);
 
-                std::unique_ptr<Loader::AppLoader> update_loader = Loader::GetLoader(update_path);
+        if (!FileUtil::Exists(update_path))
+            return metadata->smdh;
 
-                if (!update_loader)
-                    return original_smdh;
+        const std::optional<Metadata> update_metadata = ReadMetadata(update_path);
 
-                std::vector<u8> update_smdh;
-                update_loader->ReadIcon(update_smdh);
-                return update_smdh;
-            }();
+        if (!update_metadata)
+            return metadata->smdh;
 
-            if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
-                // Skip this invalid entry
-                return true;
-            }
+        return update_metadata->smdh;
+    }();
 
-            auto it = FindMatchingCompatibilityEntry(compatibility_list, program_id);
+    if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
+        // Skip this invalid entry
+        return;
+    }
 
-            // The game list uses this as compatibility number for untested games
-            QString compatibility("99");
-            if (it != compatibility_list.end())
-                compatibility = it->second.first;
+    auto it = FindMatchingCompatibilityEntry(compatibility_list, program_id);
 
-            emit EntryReady(
-                {
-                    new GameListItemPath(QString::fromStdString(physical_name), smdh, program_id,
-                                         extdata_id),
-                    new GameListItemCompat(compatibility),
-                    new GameListItemRegion(smdh),
-                    new GameListItem(
-                        QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                    new GameListItemSize(FileUtil::GetSize(physical_name)),
-                },
-                parent_dir);
+    // The game list uses this as compatibility number for untested games
+    QString compatibility("99");
+    if (it != compatibility_list.end())
+        compatibility = it->second.first;
 
-        } else if (is_dir && recursion > 0) {
-            watch_list.append(QString::fromStdString(physical_name));
-            AddFstEntriesToGameList(physical_name, recursion - 1, parent_dir);
+    emit EntryReady(
+        {
+            new GameListItemPath(QString::fromStdString(game_file.path), smdh, program_id,
+                                 metadata->extdata_id),
+            new GameListItemCompat(compatibility),
+            new GameListItemRegion(smdh),
+            new GameListItem(metadata->file_type),
+            new GameListItemSize(static_cast<u64>(metadata->size)),
+        },
+        game_file.parent_dir);
+}
+
+std::optional<GameListWorker::Metadata> GameListWorker::ReadMetadata(const std::string& path) {
+    const QFileInfo file_info(QString::fromStdString(path));
+    const qint64 size = file_info.size();
+    const qint64 modified = file_info.lastModified().toMSecsSinceEpoch();
+
+    {
+        std::lock_guard<std::mutex> lock(metadata_mutex);
+        const auto it = cached_metadata.find(path);
+        if (it != cached_metadata.end() && it->second.size == size &&
+            it->second.modified == modified) {
+            current_metadata.insert(*it);
+            return it->second;
         }
+    }
 
-        return true;
-    };
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(path);
+    if (!loader)
+        return std::nullopt;
 
-    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
+    Metadata metadata{size, modified};
+    loader->ReadProgramId(metadata.program_id);
+    loader->ReadExtdataId(metadata.extdata_id);
+    loader->ReadIcon(metadata.smdh);
+    metadata.file_type = QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()));
+
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    current_metadata[path] = metadata;
+    metadata_changed = true;
+    return metadata;
+}
+
+void GameListWorker::LoadMetadataCache() {
+    QFile file(GetMetadataCachePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    quint32 version = 0;
+    quint32 num_entries = 0;
+    stream >> version >> num_entries;
+    if (version != METADATA_CACHE_VERSION)
+        return;
+
+    for (quint32 i = 0; i < num_entries && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Metadata metadata;
+        quint64 program_id;
+        quint64 extdata_id;
+        QByteArray smdh;
+        stream >> path >> metadata.size >> metadata.modified >> program_id >> extdata_id >>
+            metadata.file_type >> smdh;
+        metadata.program_id = program_id;
+        metadata.extdata_id = extdata_id;
+        metadata.smdh.assign(smdh.begin(), smdh.end());
+        cached_metadata.emplace(path.toStdString(), std::move(metadata));
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        LOG_WARNING(Frontend, "Game list cache is corrupted, rebuilding it");
+        cached_metadata.clear();
+    }
+}
+
+void GameListWorker::SaveMetadataCache() {
+    // Files that disappeared are dropped from the cache as well
+    if (!metadata_changed && current_metadata.size() == cached_metadata.size())
+        return;
+
+    if (!FileUtil::CreateFullPath(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir)))
+        return;
+
+    QSaveFile file(GetMetadataCachePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_ERROR(Frontend, "Unable to write the game list cache");
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << METADATA_CACHE_VERSION << static_cast<quint32>(current_metadata.size());
+    for (const auto& [path, metadata] : current_metadata) {
+        const QByteArray smdh(reinterpret_cast<const char*>(metadata.smdh.data()),
+                              static_cast<int>(metadata.smdh.size()));
+        stream << QString::fromStdString(path) << metadata.size << metadata.modified
+               << static_cast<quint64>(metadata.program_id)
+               << static_cast<quint64>(metadata.extdata_id) << metadata.file_type << smdh;
+    }
+    file.commit();
 }
 
 void GameListWorker::run() {
     stop_processing = false;
+    LoadMetadataCache();
     for (UISettings::GameDir& game_dir : game_dirs) {
         if (game_dir.path == "INSTALLED") {
             QString games_path =
@@ -149,6 +269,10 @@ void GameListWorker::run() {
                                     game_list_dir);
         }
     };
+
+    AddEntries();
+    if (!stop_processing)
+        SaveMetadataCache();
     emit Finished(watch_list);
 }
 
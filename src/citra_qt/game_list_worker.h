@@ -7,8 +7,11 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <QList>
 #include <QObject>
 #include <QRunnable>
@@ -52,9 +55,45 @@ signals:
     void Finished(QStringList watch_list);
 
 private:
+    /// A supported file found while traversing the game directories
+    struct GameFile {
+        std::string path;
+        GameListDir* parent_dir;
+    };
+
+    /// Title information read from a file, cached on disk until the file changes
+    struct Metadata {
+        qint64 size;
+        qint64 modified;
+        u64 program_id;
+        u64 extdata_id;
+        QString file_type;
+        std::vector<u8> smdh;
+    };
+
+    /// Collects the supported files of a directory, which are only opened by AddEntries
     void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
                                  GameListDir* parent_dir);
 
+    /// Reads the collected files on a thread pool and emits their entries
+    void AddEntries();
+    void AddEntry(const GameFile& game_file);
+
+    /// Returns the cached metadata of a file, opening it only if it changed since it was cached
+    std::optional<Metadata> ReadMetadata(const std::string& path);
+
+    void LoadMetadataCache();
+    void SaveMetadataCache();
+
+    std::vector<GameFile> game_files;
+
+    std::mutex metadata_mutex;
+    /// Metadata loaded from the cache file
+    std::unordered_map<std::string, Metadata> cached_metadata;
+    /// Metadata of the files seen in this run, saved back to the cache file
+    std::unordered_map<std::string, Metadata> current_metadata;
+    bool metadata_changed = false;
+
     QStringList watch_list;
     const CompatibilityList& compatibility_list;
     QList<UISettings::GameDir>& game_dirs;
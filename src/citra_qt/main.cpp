@@ -828,6 +828,8 @@ void GMainWindow::BootGame(const QString& filename) {
 
     // Create and start the emulation thread
     emu_thread = std::make_unique<EmuThread>(render_window);
+    qRegisterMetaType<VideoCore::LoadCallbackStage>("VideoCore::LoadCallbackStage");
+    connect(emu_thread.get(), &EmuThread::LoadProgress, this, &GMainWindow::OnLoadProgress);
     emit EmulationStarting(emu_thread.get());
     render_window->moveContext();
     emu_thread->start();
@@ -1612,6 +1614,27 @@ void GMainWindow::UpdateStatusBar() {
     emu_frametime_label->setVisible(true);
 }
 
+void GMainWindow::OnLoadProgress(VideoCore::LoadCallbackStage stage, std::size_t value,
+                                 std::size_t total) {
+    switch (stage) {
+    case VideoCore::LoadCallbackStage::Prepare:
+        message_label->setText(tr("Loading shader cache..."));
+        message_label->setVisible(true);
+        break;
+    case VideoCore::LoadCallbackStage::Build:
+        message_label->setText(tr("Building shaders %1 / %2").arg(value).arg(total));
+        progress_bar->setMaximum(static_cast<int>(total));
+        progress_bar->setValue(static_cast<int>(value));
+        progress_bar->show();
+        break;
+    case VideoCore::LoadCallbackStage::Complete:
+        message_label->setVisible(false);
+        progress_bar->hide();
+        progress_bar->setValue(0);
+        break;
+    }
+}
+
 void GMainWindow::OnCoreError(Core::System::ResultStatus result, std::string details) {
     QString status_message;
 
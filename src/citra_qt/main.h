@@ -14,6 +14,7 @@
 #include "common/announce_multiplayer_room.h"
 #include "core/core.h"
 #include "core/hle/service/am/am.h"
+#include "video_core/rasterizer_interface.h"
 #include "ui_main.h"
 
 class AboutDialog;
@@ -185,6 +186,7 @@ private slots:
     void OnStopRecordingPlayback();
     void OnCaptureScreenshot();
     void OnCoreError(Core::System::ResultStatus, std::string);
+    void OnLoadProgress(VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total);
     /// Called whenever a user selects Help->About Citra
     void OnMenuAboutCitra();
     void OnUpdateFound(bool found, bool error);
@@ -42,6 +42,7 @@
 #include <cstring>
 #include <dirent.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -866,6 +867,19 @@ bool IOFile::Flush() {
     return m_good;
 }
 
+bool IOFile::Sync() {
+    if (!Flush() || 0 !=
+#ifdef _WIN32
+                        _commit(_fileno(m_file))
+#else
+                        fsync(fileno(m_file))
+#endif
+    )
+        m_good = false;
+
+    return m_good;
+}
+
 bool IOFile::Resize(u64 size) {
     if (!IsOpen() || 0 !=
 #ifdef _WIN32
@@ -882,4 +896,76 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFileRange::MappedFileRange(const IOFile& file, u64 offset, std::size_t size_) {
+    if (!file.IsOpen())
+        return;
+
+    const u64 file_size = file.GetSize();
+    if (offset >= file_size)
+        return;
+    size = static_cast<std::size_t>(std::min<u64>(size_, file_size - offset));
+    if (size == 0)
+        return;
+
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const u64 base_offset = offset - offset % info.dwAllocationGranularity;
+    base_size = static_cast<std::size_t>(offset - base_offset) + size;
+
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file.m_file)));
+    const HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        LOG_WARNING(Common_Filesystem, "CreateFileMapping failed: {}", GetLastErrorMsg());
+        return;
+    }
+    // The view keeps the mapping alive
+    base = MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(base_offset >> 32),
+                         static_cast<DWORD>(base_offset), base_size);
+    CloseHandle(mapping);
+    if (base == nullptr) {
+        LOG_WARNING(Common_Filesystem, "MapViewOfFile failed: {}", GetLastErrorMsg());
+        return;
+    }
+#else
+    const u64 page_size = static_cast<u64>(sysconf(_SC_PAGESIZE));
+    const u64 base_offset = offset - offset % page_size;
+    base_size = static_cast<std::size_t>(offset - base_offset) + size;
+
+    base = mmap(nullptr, base_size, PROT_READ, MAP_SHARED, fileno(file.m_file),
+                static_cast<off_t>(base_offset));
+    if (base == MAP_FAILED) {
+        LOG_WARNING(Common_Filesystem, "mmap failed: {}", GetLastErrorMsg());
+        base = nullptr;
+        return;
+    }
+#endif
+    data = static_cast<const u8*>(base) + (offset - base_offset);
+}
+
+MappedFileRange::~MappedFileRange() {
+    if (base == nullptr)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap(base, base_size);
+#endif
+}
+
+void MappedFileRange::Prefetch(std::size_t offset, std::size_t length) const {
+#if !defined(_WIN32)
+    if (data == nullptr || offset >= size)
+        return;
+    length = std::min(length, size - offset);
+
+    // madvise needs a page aligned start
+    const std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t start = static_cast<std::size_t>(data - static_cast<u8*>(base)) + offset;
+    const std::size_t aligned_start = start - start % page_size;
+    madvise(static_cast<u8*>(base) + aligned_start, start - aligned_start + length,
+            MADV_WILLNEED);
+#endif
+}
+
 } // namespace FileUtil
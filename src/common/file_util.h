@@ -250,6 +250,9 @@ public:
     bool Resize(u64 size);
     bool Flush();
 
+    // Flushes the file and has the OS write it to the storage device
+    bool Sync();
+
     // clear error state
     void Clear() {
         m_good = true;
@@ -257,10 +260,45 @@ public:
     }
 
 private:
+    friend class MappedFileRange;
+
     std::FILE* m_file = nullptr;
     bool m_good = true;
 };
 
+/**
+ * Read-only view of a range of a file, mapped into memory. The pages are those of the host's page
+ * cache, so they are shared with other processes reading the file and are not copied on reads.
+ * The file must not shrink while it is mapped.
+ */
+class MappedFileRange : public NonCopyable {
+public:
+    /// Maps the range, which is clamped to the end of the file. Check IsValid for failures.
+    MappedFileRange(const IOFile& file, u64 offset, std::size_t size);
+    ~MappedFileRange();
+
+    bool IsValid() const {
+        return data != nullptr;
+    }
+
+    const u8* GetData() const {
+        return data;
+    }
+
+    std::size_t GetSize() const {
+        return size;
+    }
+
+    /// Hints that part of the range will be read soon, so that the host starts reading it
+    void Prefetch(std::size_t offset, std::size_t length) const;
+
+private:
+    void* base = nullptr;
+    std::size_t base_size = 0;
+    const u8* data = nullptr;
+    std::size_t size = 0;
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
@@ -179,6 +179,14 @@ void ARM_Dynarmic::Run() {
     MICROPROFILE_SCOPE(ARM_Jit);
 
     jit->Run();
+
+    // Watchpoints hit by the JIT halt it, report them once execution has stopped
+    if (GDBStub::IsMemoryBreak()) {
+        Kernel::Thread* thread = system.Kernel().GetThreadManager().GetCurrentThread();
+        SaveContext(thread->context);
+        GDBStub::Break();
+        GDBStub::SendTrap(thread, 5);
+    }
 }
 
 void ARM_Dynarmic::Step() {
@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <memory>
+#include <thread>
 #include <utility>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/hle/hle.h"
@@ -22,6 +24,7 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hle/service/fs/io_worker.h"
 #include "core/hle/service/service.h"
 #include "core/hle/service/sm/sm.h"
 #include "core/hw/hw.h"
@@ -143,6 +146,24 @@ System::ResultStatus System::Load(EmuWindow& emu_window, const std::string& file
     }
     memory->SetCurrentPageTable(&kernel->GetCurrentProcess()->vm_manager.page_table);
     cheat_engine = std::make_unique<Cheats::CheatEngine>(*this);
+    content_verification_result = {};
+    stop_content_verification = false;
+    switch (Settings::values.verify_content) {
+    case Settings::ContentVerification::Off:
+        break;
+    case Settings::ContentVerification::Background:
+        // A single thread, so that the check does not take CPU time away from the emulation
+        content_verification = std::async(std::launch::async, [this] {
+            return app_loader->VerifyContent(content_verification_result,
+                                             stop_content_verification, 1);
+        });
+        break;
+    case Settings::ContentVerification::BeforeBoot:
+        ReportContentVerification(
+            app_loader->VerifyContent(content_verification_result, stop_content_verification,
+                                      std::max(std::thread::hardware_concurrency(), 1u)));
+        break;
+    }
     status = ResultStatus::Success;
     m_emu_window = &emu_window;
     m_filepath = filepath;
@@ -158,6 +179,25 @@ PerfStats::Results System::GetAndResetPerfStats() {
     return perf_stats.GetAndResetStats(timing->GetGlobalTimeUs());
 }
 
+void System::ReportContentVerification(Loader::ResultStatus result) {
+    const Loader::VerificationResult& verification = content_verification_result;
+    const char* outcome;
+    if (result != Loader::ResultStatus::Success) {
+        outcome = "NotVerified";
+    } else if (!verification.IsGood()) {
+        outcome = "Bad";
+    } else {
+        outcome = verification.stopped ? "Incomplete" : "Good";
+    }
+
+    telemetry_session->AddField(Telemetry::FieldType::Session, "VerifyContent_Result",
+                                std::string(outcome));
+    telemetry_session->AddField(Telemetry::FieldType::Session, "VerifyContent_BadExeFSSections",
+                                verification.bad_exefs_sections);
+    telemetry_session->AddField(Telemetry::FieldType::Session, "VerifyContent_BadRomFSBlocks",
+                                verification.bad_romfs_blocks);
+}
+
 void System::Reschedule() {
     if (!reschedule_pending) {
         return;
@@ -209,6 +249,7 @@ System::ResultStatus System::Init(EmuWindow& emu_window, u32 system_mode) {
 
     service_manager = std::make_shared<Service::SM::ServiceManager>(*this);
     archive_manager = std::make_unique<Service::FS::ArchiveManager>(*this);
+    fs_io_worker = std::make_unique<Service::FS::IOWorker>(*timing);
 
     HW::Init(*memory);
     Service::Init(*this);
@@ -244,6 +285,10 @@ const Service::FS::ArchiveManager& System::ArchiveManager() const {
     return *archive_manager;
 }
 
+Service::FS::IOWorker& System::FSIOWorker() {
+    return *fs_io_worker;
+}
+
 Kernel::KernelSystem& System::Kernel() {
     return *kernel;
 }
@@ -285,6 +330,12 @@ void System::RegisterSoftwareKeyboard(std::shared_ptr<Frontend::SoftwareKeyboard
 }
 
 void System::Shutdown() {
+    // Stop the content verification, which reads through the loader
+    if (content_verification.valid()) {
+        stop_content_verification = true;
+        ReportContentVerification(content_verification.get());
+    }
+
     // Log last frame performance stats
     const auto perf_results = GetAndResetPerfStats();
     telemetry_session->AddField(Telemetry::FieldType::Performance, "Shutdown_EmulationSpeed",
@@ -301,6 +352,8 @@ void System::Shutdown() {
     telemetry_session.reset();
     rpc_server.reset();
     cheat_engine.reset();
+    // Completes the queued FS writes, releasing the files they hold
+    fs_io_worker.reset();
     service_manager.reset();
     dsp_core.reset();
     cpu_core.reset();
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <future>
 #include <memory>
 #include <string>
 #include "common/common_types.h"
@@ -35,6 +37,7 @@ class ServiceManager;
 }
 namespace FS {
 class ArchiveManager;
+class IOWorker;
 }
 } // namespace Service
 
@@ -179,6 +182,9 @@ public:
     /// Gets a const reference to the archive manager
     const Service::FS::ArchiveManager& ArchiveManager() const;
 
+    /// Gets a reference to the worker running the host I/O of FS requests
+    Service::FS::IOWorker& FSIOWorker();
+
     /// Gets a reference to the kernel
     Kernel::KernelSystem& Kernel();
 
@@ -248,6 +254,9 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Adds the outcome of the content verification to the telemetry session
+    void ReportContentVerification(Loader::ResultStatus result);
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -276,7 +285,13 @@ private:
     /// RPC Server for scripting support
     std::unique_ptr<RPC::RPCServer> rpc_server;
 
+    /// Check of the application content running in the background, see verify_content
+    std::future<Loader::ResultStatus> content_verification;
+    Loader::VerificationResult content_verification_result;
+    std::atomic<bool> stop_content_verification{false};
+
     std::unique_ptr<Service::FS::ArchiveManager> archive_manager;
+    std::unique_ptr<Service::FS::IOWorker> fs_io_worker;
 
     std::unique_ptr<Memory::MemorySystem> memory;
     std::unique_ptr<Kernel::KernelSystem> kernel;
@@ -29,7 +29,7 @@ class FixSizeDiskFile : public DiskFile {
 public:
     FixSizeDiskFile(FileUtil::IOFile&& file, const Mode& mode,
                     std::unique_ptr<DelayGenerator> delay_generator_)
-        : DiskFile(std::move(file), mode, std::move(delay_generator_)) {
+        : DiskFile(std::move(file), mode, std::move(delay_generator_), true) {
         size = GetSize();
     }
 
@@ -52,6 +52,29 @@ public:
         return DiskFile::Write(offset, length, flush, buffer);
     }
 
+    ResultVal<std::size_t> WriteGather(u64 offset, bool flush,
+                                       const Memory::ScatterList& spans) override {
+        if (offset > size) {
+            return ERR_WRITE_BEYOND_END;
+        } else if (offset == size) {
+            return MakeResult<std::size_t>(0);
+        }
+
+        // Same clamp as Write, applied to the spans in order
+        Memory::ScatterList clamped;
+        u64 remaining = size - offset;
+        for (const Memory::HostSpan& span : spans) {
+            if (remaining == 0) {
+                break;
+            }
+            const auto length = static_cast<std::size_t>(std::min<u64>(span.size, remaining));
+            clamped.push_back({span.data, length});
+            remaining -= length;
+        }
+
+        return DiskFile::WriteGather(offset, flush, clamped);
+    }
+
 private:
     u64 size{};
 };
@@ -121,7 +144,7 @@ public:
 
         const auto full_path = path_parser.BuildHostPath(mount_point);
 
-        switch (path_parser.GetHostStatus(mount_point)) {
+        switch (path_parser.GetHostStatus(mount_point, *directory_index)) {
         case PathParser::InvalidMountPoint:
             LOG_CRITICAL(Service_FS, "(unreachable) Invalid mount point {}", mount_point);
             return ERROR_FILE_NOT_FOUND;
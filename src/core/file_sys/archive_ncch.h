@@ -78,7 +78,9 @@ public:
     bool Close() const override {
         return false;
     }
-    void Flush() const override {}
+    bool Flush() const override {
+        return true;
+    }
 
 private:
     std::vector<u8> file_buffer;
@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/directory_index.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -19,7 +20,8 @@ class SDMCArchive : public ArchiveBackend {
 public:
     explicit SDMCArchive(const std::string& mount_point_,
                          std::unique_ptr<DelayGenerator> delay_generator_)
-        : mount_point(mount_point_) {
+        : mount_point(mount_point_),
+          directory_index(std::make_shared<DirectoryIndex>(mount_point_)) {
         delay_generator = std::move(delay_generator_);
     }
 
@@ -42,6 +44,8 @@ public:
 protected:
     ResultVal<std::unique_ptr<FileBackend>> OpenFileBase(const Path& path, const Mode& mode) const;
     std::string mount_point;
+    /// Shared with the files opened from the archive, which may outlive it
+    std::shared_ptr<DirectoryIndex> directory_index;
 };
 
 /// File system interface to the SDMC archive
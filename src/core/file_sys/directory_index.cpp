@@ -0,0 +1,257 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/file_sys/directory_index.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace FileSys {
+
+namespace {
+
+/**
+ * Checks the status of a path on the host file system, starting from the given directory. This is
+ * used when the index does not know an entry that the host has, e.g. on case-insensitive hosts.
+ */
+PathParser::HostStatus GetStatusOnHost(std::string path, const std::vector<std::string>& components,
+                                       std::size_t first) {
+    for (std::size_t i = first; i + 1 < components.size(); ++i) {
+        path += '/' + components[i];
+        if (!FileUtil::Exists(path))
+            return PathParser::PathNotFound;
+        if (!FileUtil::IsDirectory(path))
+            return PathParser::FileInPath;
+    }
+
+    path += '/' + components.back();
+    if (!FileUtil::Exists(path))
+        return PathParser::NotFound;
+    return FileUtil::IsDirectory(path) ? PathParser::DirectoryFound : PathParser::FileFound;
+}
+
+#ifdef __linux__
+constexpr u32 WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE |
+                           IN_DELETE_SELF | IN_MOVE_SELF;
+#endif
+
+} // Anonymous namespace
+
+DirectoryIndex::DirectoryIndex(const std::string& mount_point_) : mount_point(mount_point_) {
+    while (mount_point.size() > 1 && mount_point.back() == '/')
+        mount_point.pop_back();
+
+#ifdef __linux__
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+        LOG_WARNING(Service_FS, "inotify unavailable, changes by other programs are not tracked");
+#endif
+}
+
+DirectoryIndex::~DirectoryIndex() {
+#ifdef __linux__
+    if (inotify_fd >= 0)
+        close(inotify_fd);
+#endif
+}
+
+PathParser::HostStatus DirectoryIndex::GetHostStatus(const std::string& path) {
+    const std::vector<std::string> components = Split(path);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    PollHostChanges();
+
+    const PathParser::HostStatus status = GetIndexedStatus(components);
+    if (TracksHostChanges() || components.empty())
+        return status;
+
+    // Without change notifications, what the index found may have been changed by other programs
+    // since it was scanned. Misses are already checked on the host.
+    switch (status) {
+    case PathParser::FileFound:
+    case PathParser::DirectoryFound: {
+        const std::string host_path = Join(components, components.size());
+        if (FileUtil::Exists(host_path) &&
+            FileUtil::IsDirectory(host_path) == (status == PathParser::DirectoryFound)) {
+            return status;
+        }
+        break;
+    }
+    case PathParser::FileInPath:
+        break;
+    default:
+        return status;
+    }
+
+    const PathParser::HostStatus host_status = GetStatusOnHost(mount_point, components, 0);
+    if (host_status != status)
+        listings.clear();
+    return host_status;
+}
+
+PathParser::HostStatus DirectoryIndex::GetIndexedStatus(
+    const std::vector<std::string>& components) {
+    std::shared_ptr<const Listing> listing = GetListing(mount_point);
+    if (!listing)
+        return PathParser::InvalidMountPoint;
+
+    for (std::size_t i = 0; i < components.size(); ++i) {
+        const auto itr = listing->names.find(components[i]);
+        if (itr == listing->names.end()) {
+            const std::string parent = Join(components, i);
+            if (FileUtil::Exists(parent + '/' + components[i]))
+                return GetStatusOnHost(parent, components, i);
+            return i + 1 == components.size() ? PathParser::NotFound : PathParser::PathNotFound;
+        }
+
+        const bool is_directory = listing->directory.children[itr->second].isDirectory;
+        if (i + 1 == components.size())
+            return is_directory ? PathParser::DirectoryFound : PathParser::FileFound;
+        if (!is_directory)
+            return PathParser::FileInPath;
+
+        listing = GetListing(Join(components, i + 1));
+        if (!listing)
+            return PathParser::PathNotFound;
+    }
+    return PathParser::DirectoryFound;
+}
+
+std::shared_ptr<const FileUtil::FSTEntry> DirectoryIndex::GetDirectory(const std::string& path) {
+    const std::vector<std::string> components = Split(path);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    PollHostChanges();
+
+    std::shared_ptr<const Listing> listing = GetListing(Join(components, components.size()));
+    if (!listing)
+        return nullptr;
+    return std::shared_ptr<const FileUtil::FSTEntry>(listing, &listing->directory);
+}
+
+void DirectoryIndex::Invalidate(const std::string& path) {
+    const std::vector<std::string> components = Split(path);
+    if (components.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        listings.clear();
+        return;
+    }
+
+    const std::string key = Join(components, components.size());
+    const std::string prefix = key + '/';
+
+    std::lock_guard<std::mutex> lock(mutex);
+    listings.erase(Join(components, components.size() - 1));
+    for (auto itr = listings.begin(); itr != listings.end();) {
+        if (itr->first == key || itr->first.compare(0, prefix.size(), prefix) == 0) {
+            itr = listings.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+std::vector<std::string> DirectoryIndex::Split(const std::string& path) const {
+    std::vector<std::string> parts;
+    if (path.compare(0, mount_point.size(), mount_point) == 0)
+        Common::SplitString(path.substr(mount_point.size()), '/', parts);
+
+    // Paths coming from PathParser never go above the mount point
+    std::vector<std::string> components;
+    for (std::string& part : parts) {
+        if (part.empty() || part == ".")
+            continue;
+        if (part == "..") {
+            if (!components.empty())
+                components.pop_back();
+            continue;
+        }
+        components.push_back(std::move(part));
+    }
+    return components;
+}
+
+std::string DirectoryIndex::Join(const std::vector<std::string>& components,
+                                 std::size_t count) const {
+    std::string path = mount_point;
+    for (std::size_t i = 0; i < count; ++i) {
+        path += '/';
+        path += components[i];
+    }
+    return path;
+}
+
+std::shared_ptr<const DirectoryIndex::Listing> DirectoryIndex::GetListing(const std::string& key) {
+    const auto itr = listings.find(key);
+    if (itr != listings.end())
+        return itr->second;
+
+    if (!FileUtil::IsDirectory(key))
+        return nullptr;
+
+#ifdef __linux__
+    // Watch the directory before scanning it, so that no change can fall in between
+    if (inotify_fd >= 0) {
+        const int watch = inotify_add_watch(inotify_fd, key.c_str(), WATCH_MASK);
+        if (watch >= 0)
+            watches[watch] = key;
+    }
+#endif
+
+    auto listing = std::make_shared<Listing>();
+    listing->directory.isDirectory = true;
+    listing->directory.size = FileUtil::ScanDirectoryTree(key, listing->directory);
+    listing->directory.physicalName = key;
+    for (std::size_t i = 0; i < listing->directory.children.size(); ++i)
+        listing->names.emplace(listing->directory.children[i].virtualName, i);
+
+    listings.emplace(key, listing);
+    return listing;
+}
+
+bool DirectoryIndex::TracksHostChanges() const {
+#ifdef __linux__
+    return inotify_fd >= 0;
+#else
+    return false;
+#endif
+}
+
+void DirectoryIndex::PollHostChanges() {
+#ifdef __linux__
+    if (inotify_fd < 0)
+        return;
+
+    alignas(inotify_event) std::array<char, 4096> buffer;
+    while (true) {
+        const ssize_t length = read(inotify_fd, buffer.data(), buffer.size());
+        if (length <= 0)
+            return;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                listings.clear();
+                continue;
+            }
+
+            const auto itr = watches.find(event->wd);
+            if (itr == watches.end())
+                continue;
+            listings.erase(itr->second);
+            if (event->mask & IN_IGNORED)
+                watches.erase(itr);
+        }
+    }
+#endif
+}
+
+} // namespace FileSys
@@ -0,0 +1,85 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "core/file_sys/path_parser.h"
+
+namespace FileSys {
+
+/**
+ * In-memory index of the host directories under the mount point of an archive. The listing of a
+ * directory is read from the host the first time it is needed, and dropped again when the archive
+ * changes the directory, so that checking paths and opening directories do not touch the host
+ * file system on every request. On Linux, changes made by other programs are picked up through
+ * inotify. Elsewhere, the entries found by GetHostStatus are checked on the host again, while
+ * directory listings only see these changes when the archive is opened again.
+ */
+class DirectoryIndex {
+public:
+    explicit DirectoryIndex(const std::string& mount_point_);
+    ~DirectoryIndex();
+
+    /**
+     * Checks the status of the file or directory at a host path under the mount point, such as
+     * one built by PathParser::BuildHostPath, with the same results as PathParser::GetHostStatus.
+     */
+    PathParser::HostStatus GetHostStatus(const std::string& path);
+
+    /// Returns the listing of the directory at a host path, or nullptr if it does not exist
+    std::shared_ptr<const FileUtil::FSTEntry> GetDirectory(const std::string& path);
+
+    /**
+     * Forgets the entry at a host path, as well as everything under it, after the archive created,
+     * deleted, renamed or resized it
+     */
+    void Invalidate(const std::string& path);
+
+private:
+    struct Listing {
+        FileUtil::FSTEntry directory;
+        /// Position of every child in the directory entry, by name
+        std::unordered_map<std::string, std::size_t> names;
+    };
+
+    /// Splits a host path into its components under the mount point
+    std::vector<std::string> Split(const std::string& path) const;
+
+    /// Returns the host path of a directory from its components, up to the given count
+    std::string Join(const std::vector<std::string>& components, std::size_t count) const;
+
+    /// Returns the listing of a directory, scanning it if needed. The mutex must be held.
+    std::shared_ptr<const Listing> GetListing(const std::string& key);
+
+    /// Looks up the status of a path in the listings, scanning the missing ones. The host is only
+    /// checked for the entries the listings do not have. The mutex must be held.
+    PathParser::HostStatus GetIndexedStatus(const std::vector<std::string>& components);
+
+    /// Whether the changes made by other programs are reported by the host
+    bool TracksHostChanges() const;
+
+    /// Drops the listings of the directories changed by other programs. The mutex must be held.
+    void PollHostChanges();
+
+    std::string mount_point;
+
+    std::mutex mutex;
+    /// Listings of the scanned directories, by host path without a trailing separator
+    std::unordered_map<std::string, std::shared_ptr<const Listing>> listings;
+
+#ifdef __linux__
+    int inotify_fd = -1;
+    /// Host path of the directory of every watch descriptor
+    std::unordered_map<int, std::string> watches;
+#endif
+};
+
+} // namespace FileSys
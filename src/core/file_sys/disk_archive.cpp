@@ -4,23 +4,41 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "core/file_sys/directory_index.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
 
 namespace FileSys {
 
+namespace {
+
+/// Largest amount of data held in the write buffer of a file, larger writes go to the file directly
+constexpr std::size_t WRITE_BUFFER_SIZE = 0x40000;
+
+} // Anonymous namespace
+
+DiskFile::~DiskFile() {
+    Close();
+}
+
 ResultVal<std::size_t> DiskFile::Read(const u64 offset, const std::size_t length,
                                       u8* buffer) const {
     if (!mode.read_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
+    std::lock_guard<std::mutex> lock(mutex);
+    if (BufferOverlaps(offset, length))
+        WriteOutBuffer();
+
     file->Seek(offset, SEEK_SET);
     return MakeResult<std::size_t>(file->ReadBytes(buffer, length));
 }
@@ -30,25 +48,179 @@ ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t lengt
     if (!mode.write_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    std::size_t written = file->WriteBytes(buffer, length);
-    if (flush)
-        file->Flush();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (write_out_failed)
+        return ERROR_INSUFFICIENT_SPACE;
+
+    std::size_t written = length;
+    if (write_back && length <= WRITE_BUFFER_SIZE) {
+        BufferWrite(offset, buffer, length);
+    } else {
+        WriteOutBuffer();
+        file->Seek(offset, SEEK_SET);
+        written = file->WriteBytes(buffer, length);
+        needs_sync = true;
+    }
+
+    // The guest expects the data to have reached the storage when a flushing write returns
+    if (flush && !FlushLocked())
+        return ERROR_INSUFFICIENT_SPACE;
     return MakeResult<std::size_t>(written);
 }
 
+ResultVal<std::size_t> DiskFile::ReadScatter(const u64 offset,
+                                             const Memory::ScatterList& spans) const {
+    if (!mode.read_flag)
+        return ERROR_INVALID_OPEN_FLAGS;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t total_size = 0;
+    for (const Memory::HostSpan& span : spans)
+        total_size += span.size;
+    if (BufferOverlaps(offset, total_size))
+        WriteOutBuffer();
+
+    file->Seek(offset, SEEK_SET);
+    std::size_t total_read = 0;
+    for (const Memory::HostSpan& span : spans) {
+        const std::size_t read = file->ReadBytes(span.data, span.size);
+        total_read += read;
+        if (read != span.size)
+            break;
+    }
+    return MakeResult<std::size_t>(total_read);
+}
+
+ResultVal<std::size_t> DiskFile::WriteGather(const u64 offset, const bool flush,
+                                             const Memory::ScatterList& spans) {
+    if (!mode.write_flag)
+        return ERROR_INVALID_OPEN_FLAGS;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (write_out_failed)
+        return ERROR_INSUFFICIENT_SPACE;
+
+    std::size_t total_size = 0;
+    for (const Memory::HostSpan& span : spans)
+        total_size += span.size;
+
+    std::size_t total_written = 0;
+    if (write_back && total_size <= WRITE_BUFFER_SIZE) {
+        for (const Memory::HostSpan& span : spans) {
+            BufferWrite(offset + total_written, span.data, span.size);
+            total_written += span.size;
+        }
+    } else {
+        WriteOutBuffer();
+        file->Seek(offset, SEEK_SET);
+        for (const Memory::HostSpan& span : spans) {
+            const std::size_t written = file->WriteBytes(span.data, span.size);
+            total_written += written;
+            if (written != span.size)
+                break;
+        }
+        needs_sync = true;
+    }
+
+    if (flush && !FlushLocked())
+        return ERROR_INSUFFICIENT_SPACE;
+    return MakeResult<std::size_t>(total_written);
+}
+
 u64 DiskFile::GetSize() const {
-    return file->GetSize();
+    std::lock_guard<std::mutex> lock(mutex);
+    const u64 size = file->GetSize();
+    if (write_buffer.empty())
+        return size;
+    return std::max<u64>(size, write_buffer_offset + write_buffer.size());
 }
 
 bool DiskFile::SetSize(const u64 size) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    WriteOutBuffer();
     file->Resize(size);
     file->Flush();
+    needs_sync = true;
+    if (directory_index)
+        directory_index->Invalidate(host_path);
     return true;
 }
 
 bool DiskFile::Close() const {
-    return file->Close();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file->IsOpen())
+        return true;
+
+    WriteOutBuffer();
+    if (write_back && needs_sync &&
+        Settings::values.save_data_sync != Settings::SaveDataSync::Never) {
+        file->Sync();
+    }
+    const bool closed = file->Close();
+
+    // Writes may have changed the size listed in the index
+    if (directory_index && mode.write_flag)
+        directory_index->Invalidate(host_path);
+    return closed;
+}
+
+void DiskFile::SetDirectoryIndex(std::shared_ptr<DirectoryIndex> index, std::string path) {
+    directory_index = std::move(index);
+    host_path = std::move(path);
+}
+
+bool DiskFile::Flush() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return FlushLocked();
+}
+
+bool DiskFile::FlushLocked() const {
+    if (!file->IsOpen())
+        return !write_out_failed;
+
+    WriteOutBuffer();
+    if (write_back && needs_sync &&
+        Settings::values.save_data_sync == Settings::SaveDataSync::OnFlush) {
+        file->Sync();
+        needs_sync = false;
+    } else {
+        file->Flush();
+    }
+    return !write_out_failed;
+}
+
+void DiskFile::BufferWrite(const u64 offset, const u8* data, const std::size_t length) {
+    const u64 buffer_end = write_buffer_offset + write_buffer.size();
+    if (!write_buffer.empty() && (offset < write_buffer_offset || offset > buffer_end ||
+                                  offset + length - write_buffer_offset > WRITE_BUFFER_SIZE)) {
+        WriteOutBuffer();
+    }
+
+    if (write_buffer.empty())
+        write_buffer_offset = offset;
+    const std::size_t position = static_cast<std::size_t>(offset - write_buffer_offset);
+    if (position + length > write_buffer.size())
+        write_buffer.resize(position + length);
+    std::memcpy(write_buffer.data() + position, data, length);
+}
+
+void DiskFile::WriteOutBuffer() const {
+    if (write_buffer.empty())
+        return;
+
+    file->Seek(write_buffer_offset, SEEK_SET);
+    if (file->WriteBytes(write_buffer.data(), write_buffer.size()) != write_buffer.size()) {
+        LOG_ERROR(Service_FS, "Failed to write out {} buffered bytes at offset {:#x}",
+                  write_buffer.size(), write_buffer_offset);
+        write_out_failed = true;
+    }
+    write_buffer.clear();
+    needs_sync = true;
+}
+
+bool DiskFile::BufferOverlaps(const u64 offset, const std::size_t length) const {
+    return !write_buffer.empty() && offset < write_buffer_offset + write_buffer.size() &&
+           offset + length > write_buffer_offset;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -60,6 +232,10 @@ DiskDirectory::DiskDirectory(const std::string& path) {
     children_iterator = directory.children.begin();
 }
 
+DiskDirectory::DiskDirectory(const FileUtil::FSTEntry& directory) : directory(directory) {
+    children_iterator = this->directory.children.begin();
+}
+
 u32 DiskDirectory::Read(const u32 count, Entry* entries) {
     u32 entries_read = 0;
 
@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "common/common_types.h"
@@ -20,35 +21,85 @@
 
 namespace FileSys {
 
+class DirectoryIndex;
+
 class DiskFile : public FileBackend {
 public:
+    /**
+     * @param write_back Whether small writes are buffered and coalesced in memory until the file
+     * is flushed or closed, which save data archives use since titles often write their saves in
+     * many small records
+     */
     DiskFile(FileUtil::IOFile&& file_, const Mode& mode_,
-             std::unique_ptr<DelayGenerator> delay_generator_)
-        : file(new FileUtil::IOFile(std::move(file_))) {
+             std::unique_ptr<DelayGenerator> delay_generator_, bool write_back = false)
+        : file(new FileUtil::IOFile(std::move(file_))), write_back(write_back) {
         delay_generator = std::move(delay_generator_);
         mode.hex = mode_.hex;
     }
 
+    ~DiskFile() override;
+
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
+    ResultVal<std::size_t> ReadScatter(u64 offset, const Memory::ScatterList& spans) const override;
+    ResultVal<std::size_t> WriteGather(u64 offset, bool flush,
+                                       const Memory::ScatterList& spans) override;
+    bool SupportsBackgroundIO() const override {
+        return true;
+    }
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override;
+    bool Flush() const override;
 
-    void Flush() const override {
-        file->Flush();
-    }
+    /// Has the file drop its entry from the index of its archive when it is resized or closed
+    void SetDirectoryIndex(std::shared_ptr<DirectoryIndex> index, std::string path);
 
 protected:
     Mode mode;
     std::unique_ptr<FileUtil::IOFile> file;
+
+private:
+    /// Writes out the buffered data and flushes the file, syncing it if the policy asks for it.
+    /// Returns false if buffered data could not be written out. The mutex must be held.
+    bool FlushLocked() const;
+
+    /// Adds a write to the buffer, writing out the buffered data first if they are not adjacent.
+    /// The mutex must be held.
+    void BufferWrite(u64 offset, const u8* data, std::size_t length);
+
+    /// Writes the buffered data to the file. The mutex must be held.
+    void WriteOutBuffer() const;
+
+    /// Whether the buffered data overlaps the given range of the file
+    bool BufferOverlaps(u64 offset, std::size_t length) const;
+
+    bool write_back;
+
+    std::shared_ptr<DirectoryIndex> directory_index;
+    std::string host_path;
+
+    // Guards the file, since the FS I/O worker and the periodic flush of the archive manager
+    // access it from different threads
+    mutable std::mutex mutex;
+    mutable std::vector<u8> write_buffer;
+    mutable u64 write_buffer_offset = 0;
+    /// Whether data was written to the file since it was last synced to the storage device
+    mutable bool needs_sync = false;
+    /// Whether writing out buffered data failed. The guest was already told these writes
+    /// succeeded, so the following writes and flushes of the file fail. The failure is reported as
+    /// running out of space, its usual cause.
+    mutable bool write_out_failed = false;
 };
 
 class DiskDirectory : public DirectoryBackend {
 public:
     explicit DiskDirectory(const std::string& path);
 
+    /// Lists the entries of a directory that was already scanned, e.g. by a DirectoryIndex
+    explicit DiskDirectory(const FileUtil::FSTEntry& directory);
+
     ~DiskDirectory() override {
         Close();
     }
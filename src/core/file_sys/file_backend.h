@@ -9,6 +9,7 @@
 #include <memory>
 #include "common/common_types.h"
 #include "core/hle/result.h"
+#include "core/memory.h"
 #include "delay_generator.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -41,6 +42,49 @@ public:
     virtual ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                          const u8* buffer) = 0;
 
+    /**
+     * Read data from the file into a list of buffers, filled in order
+     * @param offset Offset in bytes to start reading data from
+     * @param spans Buffers to read data into, usually guest memory
+     * @return Number of bytes read, or error code
+     */
+    virtual ResultVal<std::size_t> ReadScatter(u64 offset, const Memory::ScatterList& spans) const {
+        std::size_t total_read = 0;
+        for (const Memory::HostSpan& span : spans) {
+            ResultVal<std::size_t> read = Read(offset + total_read, span.size, span.data);
+            if (read.Failed())
+                return read;
+            total_read += *read;
+            if (*read != span.size)
+                break;
+        }
+        return MakeResult<std::size_t>(total_read);
+    }
+
+    /**
+     * Write data from a list of buffers to the file, in order
+     * @param offset Offset in bytes to start writing data to
+     * @param flush The flush parameters (0 == do not flush)
+     * @param spans Buffers to read data from, usually guest memory
+     * @return Number of bytes written, or error code
+     */
+    virtual ResultVal<std::size_t> WriteGather(u64 offset, bool flush,
+                                               const Memory::ScatterList& spans) {
+        std::size_t total_written = 0;
+        for (std::size_t i = 0; i < spans.size(); ++i) {
+            // Only flush once everything is written
+            const bool last = i == spans.size() - 1;
+            ResultVal<std::size_t> written =
+                Write(offset + total_written, spans[i].size, flush && last, spans[i].data);
+            if (written.Failed())
+                return written;
+            total_written += *written;
+            if (*written != spans[i].size)
+                break;
+        }
+        return MakeResult<std::size_t>(total_written);
+    }
+
     /**
      * Get the amount of time a 3ds needs to read those data
      * @param length Length in bytes of data read from file
@@ -64,6 +108,14 @@ public:
         return delay_generator->GetOpenDelayNs();
     }
 
+    /**
+     * Whether Read, Write and their scatter-gather variants can run on the FS I/O worker thread.
+     * They are then never called concurrently, but may run alongside the other FS requests.
+     */
+    virtual bool SupportsBackgroundIO() const {
+        return false;
+    }
+
     /**
      * Get the size of the file in bytes
      * @return Size of the file in bytes
@@ -85,8 +137,9 @@ public:
 
     /**
      * Flushes the file
+     * @return true if all the data written to the file reached the host
      */
-    virtual void Flush() const = 0;
+    virtual bool Flush() const = 0;
 
 protected:
     std::unique_ptr<DelayGenerator> delay_generator;
@@ -119,12 +119,17 @@ public:
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
+    bool SupportsBackgroundIO() const override {
+        return true;
+    }
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override {
         return false;
     }
-    void Flush() const override {}
+    bool Flush() const override {
+        return true;
+    }
 
 private:
     std::shared_ptr<RomFSReader> romfs_file;
@@ -148,12 +153,17 @@ public:
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
+    bool SupportsBackgroundIO() const override {
+        return true;
+    }
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override {
         return false;
     }
-    void Flush() const override {}
+    bool Flush() const override {
+        return true;
+    }
 
 private:
     std::vector<u8> romfs_file;
@@ -0,0 +1,87 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "core/file_sys/lzss.h"
+
+namespace FileSys {
+
+static constexpr u32 FOOTER_SIZE = 8;
+
+u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
+    if (size < FOOTER_SIZE)
+        return 0;
+
+    u32 offset_size;
+    std::memcpy(&offset_size, buffer + size - sizeof(u32), sizeof(u32));
+    if (offset_size > 0xFFFFFFFF - size)
+        return 0;
+    return offset_size + size;
+}
+
+bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                     u32 decompressed_size) {
+    // The whole input is copied before decoding, so the output can not be smaller
+    if (compressed_size < FOOTER_SIZE || decompressed_size < compressed_size)
+        return false;
+
+    const u8* footer = compressed + compressed_size - FOOTER_SIZE;
+
+    u32 buffer_top_and_bottom;
+    std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
+
+    const u32 header_size = (buffer_top_and_bottom >> 24) & 0xFF;
+    const u32 encoded_size = buffer_top_and_bottom & 0xFFFFFF;
+    if (header_size > compressed_size || encoded_size > compressed_size)
+        return false;
+
+    u32 out = decompressed_size;
+    u32 index = compressed_size - header_size;
+    const u32 stop_index = compressed_size - encoded_size;
+
+    std::memcpy(decompressed, compressed, compressed_size);
+    std::memset(decompressed + compressed_size, 0, decompressed_size - compressed_size);
+
+    // index > stop_index guarantees that there is a byte left to read for literals and control
+    // bytes, so only the reads of back-references and the writes need checking
+    while (index > stop_index) {
+        u8 control = compressed[--index];
+
+        for (unsigned i = 0; i < 8 && index > stop_index && out > 0; i++, control <<= 1) {
+            if (!(control & 0x80)) {
+                decompressed[--out] = compressed[--index];
+                continue;
+            }
+
+            // Check if compression is out of bounds
+            if (index < 2)
+                return false;
+            index -= 2;
+
+            const u32 segment_info = compressed[index] | (compressed[index + 1] << 8);
+            const u32 segment_size = ((segment_info >> 12) & 15) + 3;
+            // Distance between a byte and the byte it is copied from, at least 3
+            const u32 distance = (segment_info & 0x0FFF) + 3;
+
+            // Check if compression is out of bounds
+            if (out < segment_size || out - 1 + distance >= decompressed_size)
+                return false;
+
+            // The bytes are produced backwards, each copied from the byte distance above it. Chunks
+            // of at most distance bytes only read bytes that are already final, so they can be
+            // copied at once, which is the whole segment for all but short-period repeats.
+            u32 remaining = segment_size;
+            while (remaining > 0) {
+                const u32 chunk = std::min(remaining, distance);
+                out -= chunk;
+                std::memcpy(decompressed + out, decompressed + out + distance, chunk);
+                remaining -= chunk;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace FileSys
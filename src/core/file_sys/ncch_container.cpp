@@ -2,19 +2,31 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
 #include <cinttypes>
 #include <cstring>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <thread>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
+#include <fmt/format.h>
+#include "common/alignment.h"
+#include "common/common_paths.h"
 #include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "core/core.h"
+#include "core/file_sys/lzss.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/seed_db.h"
 #include "core/hw/aes/key.h"
 #include "core/loader/loader.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
@@ -71,86 +83,151 @@ static void ApplyIPS(std::vector<u8>& ips, std::vector<u8>& buffer) {
     }
 }
 
+/// Size of the chunks in which the RomFS is decrypted into the decrypted content cache
+static constexpr std::size_t kDecryptChunkSize = 0x400000;
+
+/// Header of the files in the decrypted content and decompressed code caches
+struct CacheFileHeader {
+    u32_le magic;
+    u32_le version;
+    u64_le size; ///< Size of the data following the header
+    u64_le hash; ///< Common::ComputeHash64 of the data, or 0 if it is too large to check on load
+};
+static_assert(sizeof(CacheFileHeader) == 0x18, "CacheFileHeader has incorrect size.");
+
+static constexpr u32 kCacheFileMagic = Loader::MakeMagic('C', 'C', 'H', 'E');
+/// Bumped whenever the contents of the cache files change, so that older entries are rewritten
+static constexpr u32 kCacheFileVersion = 1;
+
 /**
- * Get the decompressed size of an LZSS compressed ExeFS file
- * @param buffer Buffer of compressed file
- * @param size Size of compressed buffer
- * @return Size of decompressed buffer
+ * Writes a file of the decrypted content or decompressed code cache through a temporary file, so
+ * that an interrupted write is never mistaken for a complete entry.
+ * @param size Size of the data
+ * @param hash Hash of the data, or 0 if it is not checked on load
+ * @param write Writes the data to the temporary file, returning false on failure
  */
-static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
-    u32 offset_size;
-    std::memcpy(&offset_size, buffer + size - sizeof(u32), sizeof(u32));
-    return offset_size + size;
+static bool WriteCacheFile(const std::string& path, u64 size, u64 hash,
+                           const std::function<bool(FileUtil::IOFile&)>& write) {
+    // Several threads, or several instances of the emulator, may be filling the same entry
+    const u64 writer_id =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+        static_cast<u64>(std::chrono::steady_clock::now().time_since_epoch().count());
+    const std::string temp_path = fmt::format("{}.{:016x}.tmp", path, writer_id);
+
+    CacheFileHeader header{};
+    header.magic = kCacheFileMagic;
+    header.version = kCacheFileVersion;
+    header.size = size;
+    header.hash = hash;
+
+    FileUtil::IOFile temp_file(temp_path, "wb");
+    const bool written = temp_file.IsOpen() &&
+                         temp_file.WriteBytes(&header, sizeof(header)) == sizeof(header) &&
+                         write(temp_file);
+    temp_file.Close();
+
+    if (written && (!FileUtil::Exists(path) || FileUtil::Delete(path)) &&
+        FileUtil::Rename(temp_path, path)) {
+        return true;
+    }
+    LOG_WARNING(Service_FS, "Could not write the cache file {}", path);
+    FileUtil::Delete(temp_path);
+    return false;
+}
+
+/// Writes a cache file holding a buffer, which is checked against its hash when loaded
+static bool WriteCacheData(const std::string& path, const std::vector<u8>& data) {
+    return WriteCacheFile(path, data.size(), Common::ComputeHash64(data.data(), data.size()),
+                          [&data](FileUtil::IOFile& cache_file) {
+                              return cache_file.WriteBytes(data.data(), data.size()) ==
+                                     data.size();
+                          });
 }
 
 /**
- * Decompress ExeFS file (compressed with LZSS)
- * @param compressed Compressed buffer
- * @param compressed_size Size of compressed buffer
- * @param decompressed Decompressed buffer
- * @param decompressed_size Size of decompressed buffer
- * @return True on success, otherwise false
+ * Reads the header of a cache file, leaving the file at the start of the data.
+ * @returns the header, or nullopt if the file is missing, truncated or from another version
  */
-static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
-                            u32 decompressed_size) {
-    const u8* footer = compressed + compressed_size - 8;
-
-    u32 buffer_top_and_bottom;
-    std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
-
-    u32 out = decompressed_size;
-    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
-    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
-
-    memset(decompressed, 0, decompressed_size);
-    memcpy(decompressed, compressed, compressed_size);
-
-    while (index > stop_index) {
-        u8 control = compressed[--index];
-
-        for (unsigned i = 0; i < 8; i++) {
-            if (index <= stop_index)
-                break;
-            if (index <= 0)
-                break;
-            if (out <= 0)
-                break;
-
-            if (control & 0x80) {
-                // Check if compression is out of bounds
-                if (index < 2)
-                    return false;
-                index -= 2;
-
-                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
-                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
-                segment_offset &= 0x0FFF;
-                segment_offset += 2;
-
-                // Check if compression is out of bounds
-                if (out < segment_size)
-                    return false;
-
-                for (unsigned j = 0; j < segment_size; j++) {
-                    // Check if compression is out of bounds
-                    if (out + segment_offset >= decompressed_size)
-                        return false;
-
-                    u8 data = decompressed[out + segment_offset];
-                    decompressed[--out] = data;
-                }
-            } else {
-                // Check if compression is out of bounds
-                if (out < 1)
-                    return false;
-                decompressed[--out] = compressed[--index];
-            }
-            control <<= 1;
-        }
+static std::optional<CacheFileHeader> ReadCacheHeader(FileUtil::IOFile& cache_file) {
+    CacheFileHeader header;
+    if (!cache_file.IsOpen() ||
+        cache_file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != kCacheFileMagic || header.version != kCacheFileVersion ||
+        cache_file.GetSize() != sizeof(header) + header.size) {
+        return {};
+    }
+    return header;
+}
+
+/// Loads the data of a cache file written by WriteCacheData, checking it against its hash
+static bool ReadCacheData(const std::string& path, std::vector<u8>& data) {
+    FileUtil::IOFile cache_file(path, "rb");
+    const auto header = ReadCacheHeader(cache_file);
+    if (!header)
+        return false;
+
+    data.resize(static_cast<std::size_t>(header->size));
+    if (cache_file.ReadBytes(data.data(), data.size()) != data.size() ||
+        Common::ComputeHash64(data.data(), data.size()) != header->hash) {
+        LOG_WARNING(Service_FS, "Ignoring the corrupted cache file {}", path);
+        return false;
     }
     return true;
 }
 
+/// Size of the RomFS data checked by one task of the integrity check
+static constexpr std::size_t kVerifyChunkSize = 0x800000;
+
+/// Checks a buffer against its SHA-256 hash
+static bool CheckHash(const u8* data, std::size_t size, const u8* expected) {
+    std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+    CryptoPP::SHA256().CalculateDigest(hash.data(), data, size);
+    return std::memcmp(hash.data(), expected, hash.size()) == 0;
+}
+
+/// Location of an IVFC level in the RomFS
+struct IVFCLevel {
+    u64 offset;
+    u64 size;
+    std::size_t block_size;
+
+    u64 NumBlocks() const {
+        return (size + block_size - 1) / block_size;
+    }
+};
+
+/**
+ * Reads blocks of an IVFC level, padding the last one with zeros as it was when it was hashed
+ * @param data Vector to read the blocks into
+ */
+static void ReadIVFCBlocks(RomFSReader& reader, const IVFCLevel& level, u64 first_block,
+                           u64 count, std::vector<u8>& data) {
+    data.assign(static_cast<std::size_t>(count * level.block_size), 0);
+    reader.ReadFile(static_cast<std::size_t>(level.offset + first_block * level.block_size),
+                    data.size(), data.data());
+}
+
+/**
+ * Checks blocks of an IVFC level against the hash data of the level above
+ * @param data Blocks to check, as read by ReadIVFCBlocks
+ * @return Number of blocks that do not match their hash
+ */
+static u64 CheckIVFCBlocks(const std::vector<u8>& data, const IVFCLevel& level, u64 first_block,
+                           const std::vector<u8>& hashes) {
+    constexpr std::size_t hash_size = CryptoPP::SHA256::DIGESTSIZE;
+    const u64 count = data.size() / level.block_size;
+    u64 bad_blocks = 0;
+    for (u64 i = 0; i < count; ++i) {
+        const u64 hash_offset = (first_block + i) * hash_size;
+        if (hash_offset + hash_size > hashes.size() ||
+            !CheckHash(&data[static_cast<std::size_t>(i * level.block_size)], level.block_size,
+                       &hashes[static_cast<std::size_t>(hash_offset)])) {
+            ++bad_blocks;
+        }
+    }
+    return bad_blocks;
+}
+
 NCCHContainer::NCCHContainer(const std::string& filepath, u32 ncch_offset)
     : ncch_offset(ncch_offset), filepath(filepath) {
     file = FileUtil::IOFile(filepath, "rb");
@@ -232,12 +309,18 @@ Loader::ResultStatus NCCHContainer::Load() {
                     }
                 }
 
-                SetKeyY(KeySlotID::NCCHSecure1, key_y_primary);
-                if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure1)) {
-                    LOG_ERROR(Service_FS, "Secure1 KeyX missing");
-                    failed_to_decrypt = true;
-                }
-                primary_key = GetNormalKey(KeySlotID::NCCHSecure1);
+                // The key slots are left untouched, as several titles may be loading at once
+                const auto generate_key = [&failed_to_decrypt](std::size_t slot_id,
+                                                               const AESKey& key_y, int secure) {
+                    const std::optional<AESKey> key = GenerateNormalKey(slot_id, key_y);
+                    if (!key) {
+                        LOG_ERROR(Service_FS, "Secure{} KeyX missing", secure);
+                        failed_to_decrypt = true;
+                    }
+                    return key.value_or(AESKey{});
+                };
+
+                primary_key = generate_key(KeySlotID::NCCHSecure1, key_y_primary, 1);
 
                 switch (ncch_header.secondary_key_slot) {
                 case 0:
@@ -246,30 +329,15 @@ Loader::ResultStatus NCCHContainer::Load() {
                     break;
                 case 1:
                     LOG_DEBUG(Service_FS, "Secure2 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure2, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure2)) {
-                        LOG_ERROR(Service_FS, "Secure2 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure2);
+                    secondary_key = generate_key(KeySlotID::NCCHSecure2, key_y_secondary, 2);
                     break;
                 case 10:
                     LOG_DEBUG(Service_FS, "Secure3 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure3, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure3)) {
-                        LOG_ERROR(Service_FS, "Secure3 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure3);
+                    secondary_key = generate_key(KeySlotID::NCCHSecure3, key_y_secondary, 3);
                     break;
                 case 11:
                     LOG_DEBUG(Service_FS, "Secure4 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure4, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure4)) {
-                        LOG_ERROR(Service_FS, "Secure4 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure4);
+                    secondary_key = generate_key(KeySlotID::NCCHSecure4, key_y_secondary, 4);
                     break;
                 }
             }
@@ -400,6 +468,22 @@ Loader::ResultStatus NCCHContainer::Load() {
 
     LoadOverrides();
 
+    if (is_encrypted && !is_tainted && Settings::values.cache_decrypted_content) {
+        // The header covers the program ID and the hashes of the content, while the secondary key
+        // is derived from the seed of seed-encrypted titles
+        const u64 content_hash = Common::ComputeHash64(&ncch_header, sizeof(ncch_header)) ^
+                                 Common::ComputeHash64(secondary_key.data(), secondary_key.size());
+        decrypted_cache_dir =
+            fmt::format("{}decrypted" DIR_SEP "{:016X}_{:016X}" DIR_SEP,
+                        FileUtil::GetUserPath(FileUtil::UserPath::CacheDir),
+                        ncch_header.program_id, content_hash);
+        if (!FileUtil::CreateFullPath(decrypted_cache_dir)) {
+            LOG_ERROR(Service_FS, "Unable to create the decrypted content cache directory {}",
+                      decrypted_cache_dir);
+            decrypted_cache_dir.clear();
+        }
+    }
+
     // We need at least one of these or overrides, practically
     if (!(has_exefs || has_romfs || is_tainted))
         return Loader::ResultStatus::Error;
@@ -485,50 +569,35 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             LOG_DEBUG(Service_FS, "{} - offset: 0x{:08X}, size: 0x{:08X}, name: {}", section_number,
                       section.offset, section.size, section.name);
 
-            s64 section_offset =
-                (section.offset + exefs_offset + sizeof(ExeFs_Header) + ncch_offset);
-            exefs_file.Seek(section_offset, SEEK_SET);
-
-            std::array<u8, 16> key;
-            if (strcmp(section.name, "icon") == 0 || strcmp(section.name, "banner") == 0) {
-                key = primary_key;
-            } else {
-                key = secondary_key;
-            }
-
-            CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(),
-                                                              exefs_ctr.data());
-            dec.Seek(section.offset + sizeof(ExeFs_Header));
-
             if (strcmp(section.name, ".code") == 0 && is_compressed) {
-                // Section is compressed, read compressed .code section...
-                std::unique_ptr<u8[]> temp_buffer;
-                try {
-                    temp_buffer.reset(new u8[section.size]);
-                } catch (std::bad_alloc&) {
-                    return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+                // Large titles take a while to decompress, so the result is kept on disk, keyed by
+                // the hash of the section in the ExeFS header
+                const std::string cache_path = GetCodeCachePath(section_number);
+                if (!cache_path.empty() && ReadCacheData(cache_path, buffer)) {
+                    LOG_DEBUG(Service_FS, "Loaded decompressed code from {}", cache_path);
+                    return Loader::ResultStatus::Success;
                 }
 
-                if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
-
-                if (is_encrypted) {
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
-                }
+                // Section is compressed, read compressed .code section...
+                std::vector<u8> temp_buffer;
+                result = ReadExeFSSection(section, temp_buffer);
+                if (result != Loader::ResultStatus::Success)
+                    return result;
 
                 // Decompress .code section...
-                u32 decompressed_size = LZSS_GetDecompressedSize(&temp_buffer[0], section.size);
+                u32 decompressed_size = LZSS_GetDecompressedSize(temp_buffer.data(), section.size);
                 buffer.resize(decompressed_size);
-                if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
+                if (!LZSS_Decompress(temp_buffer.data(), section.size, buffer.data(),
+                                     decompressed_size))
                     return Loader::ResultStatus::ErrorInvalidFormat;
+
+                if (!cache_path.empty())
+                    WriteCacheData(cache_path, buffer);
             } else {
                 // Section is uncompressed...
-                buffer.resize(section.size);
-                if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
-                if (is_encrypted) {
-                    dec.ProcessData(&buffer[0], &buffer[0], section.size);
-                }
+                result = ReadExeFSSection(section, buffer);
+                if (result != Loader::ResultStatus::Success)
+                    return result;
             }
 
             std::string override_ips = filepath + ".exefsdir/code.ips";
@@ -551,6 +620,73 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
     return Loader::ResultStatus::ErrorNotUsed;
 }
 
+Loader::ResultStatus NCCHContainer::ReadExeFSSection(const ExeFs_SectionHeader& section,
+                                                     std::vector<u8>& data) {
+    try {
+        data.resize(section.size);
+    } catch (std::bad_alloc&) {
+        return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+    }
+
+    std::string cache_path;
+    if (!decrypted_cache_dir.empty()) {
+        std::string name(section.name, strnlen(section.name, sizeof(section.name)));
+        name.erase(std::remove(name.begin(), name.end(), '.'), name.end());
+        cache_path = decrypted_cache_dir + "exefs_" + name + ".bin";
+
+        if (ReadCacheData(cache_path, data) && data.size() == section.size) {
+            LOG_DEBUG(Service_FS, "Loaded ExeFS section from {}", cache_path);
+            return Loader::ResultStatus::Success;
+        }
+        data.resize(section.size);
+    }
+
+    exefs_file.Seek(section.offset + exefs_offset + sizeof(ExeFs_Header) + ncch_offset, SEEK_SET);
+    if (exefs_file.ReadBytes(data.data(), data.size()) != data.size())
+        return Loader::ResultStatus::Error;
+    if (!is_encrypted)
+        return Loader::ResultStatus::Success;
+
+    std::array<u8, 16> key;
+    if (strcmp(section.name, "icon") == 0 || strcmp(section.name, "banner") == 0) {
+        key = primary_key;
+    } else {
+        key = secondary_key;
+    }
+
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(), exefs_ctr.data());
+    dec.Seek(section.offset + sizeof(ExeFs_Header));
+    dec.ProcessData(data.data(), data.data(), data.size());
+
+    if (!cache_path.empty())
+        WriteCacheData(cache_path, data);
+    return Loader::ResultStatus::Success;
+}
+
+std::string NCCHContainer::GetCodeCachePath(unsigned section_number) const {
+    // The decompressed code is plaintext, so it is only written out when the user opted in to
+    // keeping decrypted content
+    if (!Settings::values.cache_decrypted_content)
+        return {};
+
+    // Overrides and IPS patches make the code differ from what the hash describes
+    if (is_tainted)
+        return {};
+
+    // Hashes are stored in reverse order of the sections
+    const u8* hash = exefs_header.hashes[kMaxSections - 1 - section_number];
+    if (std::all_of(hash, hash + sizeof(exefs_header.hashes[0]), [](u8 b) { return b == 0; }))
+        return {};
+
+    const std::string dir = FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "code" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Service_FS, "Unable to create the decompressed code cache directory {}", dir);
+        return {};
+    }
+    return fmt::format("{}{:016X}_{:016X}.bin", dir, ncch_header.program_id,
+                       Common::ComputeHash64(hash, sizeof(exefs_header.hashes[0])));
+}
+
 Loader::ResultStatus NCCHContainer::LoadOverrideExeFSSection(const char* name,
                                                              std::vector<u8>& buffer) {
     std::string override_name;
@@ -613,6 +749,23 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
     if (!romfs_file_inner.IsOpen())
         return Loader::ResultStatus::Error;
 
+    if (is_encrypted && !decrypted_cache_dir.empty()) {
+        const std::string cache_path = decrypted_cache_dir + "romfs.bin";
+        FileUtil::IOFile cache_file(cache_path, "rb");
+        const auto header = ReadCacheHeader(cache_file);
+        if (!header || header->size != romfs_size) {
+            cache_file.Close();
+            if (WriteDecryptedRomFS(cache_path, romfs_offset, romfs_size))
+                cache_file = FileUtil::IOFile(cache_path, "rb");
+        }
+        if (cache_file.IsOpen()) {
+            LOG_DEBUG(Service_FS, "Loaded RomFS from {}", cache_path);
+            romfs_file = std::make_shared<RomFSReader>(std::move(cache_file),
+                                                       sizeof(CacheFileHeader), romfs_size);
+            return Loader::ResultStatus::Success;
+        }
+    }
+
     if (is_encrypted) {
         romfs_file = std::make_shared<RomFSReader>(std::move(romfs_file_inner), romfs_offset,
                                                    romfs_size, secondary_key, romfs_ctr, 0x1000);
@@ -624,6 +777,35 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
     return Loader::ResultStatus::Success;
 }
 
+bool NCCHContainer::WriteDecryptedRomFS(const std::string& path, u32 romfs_offset,
+                                        u32 romfs_size) {
+    LOG_INFO(Service_FS, "Writing the decrypted RomFS to {}", path);
+
+    FileUtil::IOFile romfs_file_inner(filepath, "rb");
+    if (!romfs_file_inner.IsOpen())
+        return false;
+    romfs_file_inner.Seek(romfs_offset, SEEK_SET);
+
+    // The RomFS is too large to hash on every boot, its IVFC hashes cover it instead
+    return WriteCacheFile(path, romfs_size, 0, [&](FileUtil::IOFile& cache_file) {
+        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(
+            secondary_key.data(), secondary_key.size(), romfs_ctr.data());
+        dec.Seek(0x1000);
+
+        std::vector<u8> chunk(kDecryptChunkSize);
+        for (u32 position = 0; position < romfs_size;) {
+            const std::size_t length = std::min<std::size_t>(chunk.size(), romfs_size - position);
+            if (romfs_file_inner.ReadBytes(chunk.data(), length) != length)
+                return false;
+            dec.ProcessData(chunk.data(), chunk.data(), length);
+            if (cache_file.WriteBytes(chunk.data(), length) != length)
+                return false;
+            position += static_cast<u32>(length);
+        }
+        return true;
+    });
+}
+
 Loader::ResultStatus NCCHContainer::ReadOverrideRomFS(std::shared_ptr<RomFSReader>& romfs_file) {
     // Check for RomFS overrides
     std::string split_filepath = filepath + ".romfs";
@@ -711,4 +893,227 @@ bool NCCHContainer::HasExHeader() {
     return has_exheader;
 }
 
+Loader::ResultStatus NCCHContainer::VerifyIntegrity(Loader::VerificationResult& result,
+                                                    const std::atomic<bool>& stop,
+                                                    std::size_t max_threads) {
+    Loader::ResultStatus status = Load();
+    if (status != Loader::ResultStatus::Success)
+        return status;
+    if (!has_header)
+        return Loader::ResultStatus::ErrorNotUsed;
+
+    // The headers are read again, as those loaded may come from overrides. The container may be
+    // in use on other threads, so none of its files are used either.
+    FileUtil::IOFile header_file(filepath, "rb");
+    if (!header_file.IsOpen())
+        return Loader::ResultStatus::Error;
+
+    LOG_INFO(Service_FS, "Verifying {}", filepath);
+    const auto start_time = std::chrono::steady_clock::now();
+
+    bool headers_good = true;
+    std::atomic<u32> bad_exefs_sections{0};
+    std::atomic<u64> bad_romfs_blocks{0};
+    std::atomic<u64> bytes_hashed{0};
+
+    // Every worker thread reads through its own files, so that reading, decrypting and hashing
+    // all run in parallel
+    struct Worker {
+        FileUtil::IOFile exefs_file;
+        std::unique_ptr<RomFSReader> romfs_reader;
+        std::vector<u8> buffer;
+    };
+    std::vector<std::function<void(Worker&)>> tasks;
+
+    const u64 exefs_start = ncch_offset + static_cast<u64>(ncch_header.exefs_offset) * kBlockSize;
+    ExeFs_Header header;
+    if (ncch_header.exefs_size != 0 && header_file.Seek(exefs_start, SEEK_SET) &&
+        header_file.ReadBytes(&header, sizeof(header)) == sizeof(header)) {
+        if (is_encrypted) {
+            CryptoPP::byte* data = reinterpret_cast<CryptoPP::byte*>(&header);
+            CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption(primary_key.data(), primary_key.size(),
+                                                          exefs_ctr.data())
+                .ProcessData(data, data, sizeof(header));
+        }
+
+        // The hashed region is only ever the header itself
+        if (ncch_header.exefs_hash_region_size * kBlockSize == sizeof(header))
+            headers_good &= CheckHash(reinterpret_cast<const u8*>(&header), sizeof(header),
+                                      ncch_header.exefs_super_block_hash);
+
+        for (int section_number = 0; section_number < kMaxSections; section_number++) {
+            const ExeFs_SectionHeader section = header.section[section_number];
+            if (section.size == 0)
+                continue;
+
+            std::array<u8, 0x20> hash;
+            std::memcpy(hash.data(), header.hashes[kMaxSections - 1 - section_number],
+                        hash.size());
+            tasks.emplace_back([this, section, hash, exefs_start, &bad_exefs_sections,
+                                &bytes_hashed](Worker& worker) {
+                if (!worker.exefs_file.IsOpen())
+                    worker.exefs_file.Open(filepath, "rb");
+
+                const u64 section_start = exefs_start + sizeof(ExeFs_Header) + section.offset;
+                worker.buffer.resize(section.size);
+                bool good = worker.exefs_file.Seek(section_start, SEEK_SET) &&
+                            worker.exefs_file.ReadBytes(worker.buffer.data(), section.size) ==
+                                section.size;
+                if (good && is_encrypted) {
+                    const bool primary = std::strncmp(section.name, "icon", 8) == 0 ||
+                                         std::strncmp(section.name, "banner", 8) == 0;
+                    const std::array<u8, 16>& key = primary ? primary_key : secondary_key;
+                    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(),
+                                                                      exefs_ctr.data());
+                    dec.Seek(section.offset + sizeof(ExeFs_Header));
+                    dec.ProcessData(worker.buffer.data(), worker.buffer.data(), section.size);
+                }
+                good = good && CheckHash(worker.buffer.data(), section.size, hash.data());
+                bytes_hashed += section.size;
+
+                if (!good) {
+                    LOG_ERROR(Service_FS, "ExeFS section {} of {} does not match its hash",
+                              std::string(section.name, strnlen(section.name, 8)), filepath);
+                    ++bad_exefs_sections;
+                }
+            });
+        }
+    } else if (ncch_header.exefs_size != 0) {
+        headers_good = false;
+    }
+
+    // The levels above level 3 are small, they are read and checked before the level 3 tasks
+    std::vector<u8> level_1_data;
+    std::vector<u8> level_2_data;
+    IVFCLevel level_3{};
+    const u64 romfs_start = ncch_offset + static_cast<u64>(ncch_header.romfs_offset) * kBlockSize;
+    const u64 romfs_size = static_cast<u64>(ncch_header.romfs_size) * kBlockSize;
+    const auto make_romfs_reader = [this, romfs_start, romfs_size] {
+        FileUtil::IOFile romfs_file(filepath, "rb");
+        std::unique_ptr<RomFSReader> reader;
+        if (is_encrypted) {
+            reader = std::make_unique<RomFSReader>(std::move(romfs_file), romfs_start, romfs_size,
+                                                   secondary_key, romfs_ctr, 0);
+        } else {
+            reader = std::make_unique<RomFSReader>(std::move(romfs_file), romfs_start, romfs_size);
+        }
+        // Every block is read once, caching them would only add copies
+        reader->SetCacheSize(0);
+        return reader;
+    };
+
+    if (has_romfs) {
+        std::unique_ptr<RomFSReader> reader = make_romfs_reader();
+
+        std::vector<u8> hash_region(ncch_header.romfs_hash_region_size * kBlockSize);
+        IVFC_Header ivfc;
+        const bool read_good =
+            reader->ReadFile(0, hash_region.size(), hash_region.data()) == hash_region.size() &&
+            reader->ReadFile(0, sizeof(ivfc), reinterpret_cast<u8*>(&ivfc)) == sizeof(ivfc);
+        headers_good &= read_good && CheckHash(hash_region.data(), hash_region.size(),
+                                               ncch_header.romfs_super_block_hash);
+
+        std::array<IVFCLevel, 3> levels{};
+        // The master hash is part of the hashed region
+        bool layout_good = read_good && ivfc.magic == Loader::MakeMagic('I', 'V', 'F', 'C') &&
+                           ivfc.version == 0x10000 &&
+                           sizeof(ivfc) + ivfc.master_hash_size <= hash_region.size();
+        for (std::size_t i = 0; i < levels.size() && layout_good; ++i) {
+            layout_good = ivfc.levels[i].block_size_log2 >= 9 &&
+                          ivfc.levels[i].block_size_log2 <= 24 &&
+                          ivfc.levels[i].hash_data_size <= romfs_size;
+            levels[i].size = ivfc.levels[i].hash_data_size;
+            levels[i].block_size = std::size_t(1) << ivfc.levels[i].block_size_log2;
+        }
+
+        if (layout_good) {
+            // Level 3 comes first, right after the master hash, followed by levels 1 and 2
+            levels[2].offset =
+                Common::AlignUp<u64>(sizeof(ivfc) + ivfc.master_hash_size, levels[2].block_size);
+            levels[0].offset =
+                Common::AlignUp<u64>(levels[2].offset + levels[2].size, levels[2].block_size);
+            levels[1].offset =
+                Common::AlignUp<u64>(levels[0].offset + levels[0].size, levels[0].block_size);
+            layout_good = levels[1].offset + levels[1].size <= romfs_size;
+        }
+
+        if (layout_good) {
+            std::vector<u8> master_hash(ivfc.master_hash_size);
+            reader->ReadFile(sizeof(ivfc), master_hash.size(), master_hash.data());
+
+            ReadIVFCBlocks(*reader, levels[0], 0, levels[0].NumBlocks(), level_1_data);
+            ReadIVFCBlocks(*reader, levels[1], 0, levels[1].NumBlocks(), level_2_data);
+            bad_romfs_blocks += CheckIVFCBlocks(level_1_data, levels[0], 0, master_hash);
+            bad_romfs_blocks += CheckIVFCBlocks(level_2_data, levels[1], 0, level_1_data);
+            bytes_hashed += level_1_data.size() + level_2_data.size();
+            level_3 = levels[2];
+        } else {
+            LOG_ERROR(Service_FS, "RomFS of {} has an invalid IVFC header", filepath);
+            headers_good = false;
+        }
+    }
+
+    const u64 blocks_per_task =
+        level_3.block_size != 0 ? std::max<u64>(kVerifyChunkSize / level_3.block_size, 1) : 1;
+    const u64 num_blocks = level_3.block_size != 0 ? level_3.NumBlocks() : 0;
+    for (u64 first = 0; first < num_blocks; first += blocks_per_task) {
+        const u64 count = std::min(blocks_per_task, num_blocks - first);
+        tasks.emplace_back([&, first, count](Worker& worker) {
+            if (!worker.romfs_reader)
+                worker.romfs_reader = make_romfs_reader();
+            ReadIVFCBlocks(*worker.romfs_reader, level_3, first, count, worker.buffer);
+            const u64 bad_blocks = CheckIVFCBlocks(worker.buffer, level_3, first, level_2_data);
+            bytes_hashed += worker.buffer.size();
+
+            if (bad_blocks != 0) {
+                LOG_ERROR(Service_FS, "{} RomFS blocks at 0x{:X} of {} do not match their hash",
+                          bad_blocks, level_3.offset + first * level_3.block_size, filepath);
+                bad_romfs_blocks += bad_blocks;
+            }
+        });
+    }
+
+    std::atomic<std::size_t> next_task{0};
+    const auto run_tasks = [&] {
+        Worker worker;
+        while (!stop) {
+            const std::size_t task = next_task++;
+            if (task >= tasks.size())
+                return;
+            tasks[task](worker);
+        }
+    };
+
+    const std::size_t num_threads = std::min(std::max<std::size_t>(max_threads, 1), tasks.size());
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < num_threads; ++i)
+        threads.emplace_back(run_tasks);
+    run_tasks();
+    for (std::thread& thread : threads)
+        thread.join();
+
+    result.headers_good &= headers_good;
+    result.bad_exefs_sections += bad_exefs_sections;
+    result.bad_romfs_blocks += bad_romfs_blocks;
+    result.bytes_hashed += bytes_hashed;
+    if (stop) {
+        result.stopped = true;
+        LOG_INFO(Service_FS, "Stopped verifying {}", filepath);
+        return Loader::ResultStatus::Success;
+    }
+
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    if (headers_good && bad_exefs_sections == 0 && bad_romfs_blocks == 0) {
+        LOG_INFO(Service_FS, "Verified {}: {} MiB in {:.1f} s, {:.0f} MiB/s", filepath,
+                 bytes_hashed >> 20, seconds, (bytes_hashed >> 20) / std::max(seconds, 0.001));
+    } else {
+        LOG_ERROR(Service_FS,
+                  "{} is corrupted: headers {}, {} bad ExeFS sections, {} bad RomFS blocks",
+                  filepath, headers_good ? "good" : "bad", bad_exefs_sections.load(),
+                  bad_romfs_blocks.load());
+    }
+    return Loader::ResultStatus::Success;
+}
+
 } // namespace FileSys
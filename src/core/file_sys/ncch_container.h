@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -88,6 +89,30 @@ struct ExeFs_Header {
     u8 hashes[8][0x20];
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// IVFC (integrity verification) headers of the RomFS
+
+#pragma pack(push, 1)
+struct IVFC_LevelHeader {
+    u64_le logical_offset;
+    u64_le hash_data_size;
+    u32_le block_size_log2;
+    u8 reserved[4];
+};
+
+struct IVFC_Header {
+    u32_le magic;
+    u32_le version;
+    u32_le master_hash_size;
+    IVFC_LevelHeader levels[3];
+    u8 reserved[4];
+    u32_le optional_info_size;
+    u8 padding[4];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(IVFC_Header) == 0x60, "IVFC header structure size is wrong");
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // ExHeader (executable file system header) headers
 
@@ -289,11 +314,45 @@ public:
      */
     bool HasExHeader();
 
+    /**
+     * Checks the ExeFS sections and every IVFC level of the RomFS against their SHA-256 hashes,
+     * spreading the work over several threads. The outcome is logged. Overrides are not checked.
+     * @param result Reference to add the outcome of the check to
+     * @param stop Stops the check early when set
+     * @param max_threads Number of threads doing the check, including the calling one
+     * @return ResultStatus result of function
+     */
+    Loader::ResultStatus VerifyIntegrity(Loader::VerificationResult& result,
+                                         const std::atomic<bool>& stop, std::size_t max_threads);
+
     NCCH_Header ncch_header;
     ExeFs_Header exefs_header;
     ExHeader_Header exheader_header;
 
 private:
+    /**
+     * Reads an ExeFS section and decrypts it if needed, going through the decrypted content
+     * cache when it is enabled
+     * @param section Header of the section to read
+     * @param data Vector to read data into
+     * @return ResultStatus result of function
+     */
+    Loader::ResultStatus ReadExeFSSection(const ExeFs_SectionHeader& section,
+                                          std::vector<u8>& data);
+
+    /**
+     * Gets the path of the decompressed code cache file of a .code section
+     * @return the path, empty if the section can not be cached or caching decrypted content is
+     * disabled
+     */
+    std::string GetCodeCachePath(unsigned section_number) const;
+
+    /**
+     * Decrypts the whole RomFS into a file of the decrypted content cache
+     * @return true if the file was written
+     */
+    bool WriteDecryptedRomFS(const std::string& path, u32 romfs_offset, u32 romfs_size);
+
     bool has_header = false;
     bool has_exheader = false;
     bool has_exefs = false;
@@ -314,6 +373,9 @@ private:
     u32 ncch_offset = 0; // Offset to NCCH header, can be 0 for NCCHs or non-zero for CIAs/NCSDs
     u32 exefs_offset = 0;
 
+    /// Directory of the decrypted content cache entry of this NCCH, empty if it is not cached
+    std::string decrypted_cache_dir;
+
     std::string filepath;
     FileUtil::IOFile file;
     FileUtil::IOFile exefs_file;
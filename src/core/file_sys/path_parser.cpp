@@ -6,6 +6,7 @@
 #include <set>
 #include "common/file_util.h"
 #include "common/string_util.h"
+#include "core/file_sys/directory_index.h"
 #include "core/file_sys/path_parser.h"
 
 namespace FileSys {
@@ -85,6 +86,11 @@ PathParser::HostStatus PathParser::GetHostStatus(const std::string& mount_point)
     return FileFound;
 }
 
+PathParser::HostStatus PathParser::GetHostStatus(const std::string& mount_point,
+                                                 DirectoryIndex& index) const {
+    return index.GetHostStatus(BuildHostPath(mount_point));
+}
+
 std::string PathParser::BuildHostPath(const std::string& mount_point) const {
     std::string path = mount_point;
     for (auto& node : path_sequence) {
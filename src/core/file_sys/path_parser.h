@@ -10,6 +10,8 @@
 
 namespace FileSys {
 
+class DirectoryIndex;
+
 /**
  * A helper class parsing and verifying a string-type Path.
  * Every archives with a sub file system should use this class to parse the path argument and check
@@ -49,6 +51,9 @@ public:
     /// Checks the status of the specified file / directory by the Path on the host file system.
     HostStatus GetHostStatus(const std::string& mount_point) const;
 
+    /// Checks the status of the specified file / directory by the Path in a directory index.
+    HostStatus GetHostStatus(const std::string& mount_point, DirectoryIndex& index) const;
+
     /// Builds a full path on the host file system.
     std::string BuildHostPath(const std::string& mount_point) const;
 
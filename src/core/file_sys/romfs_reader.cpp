@@ -1,22 +1,170 @@
 #include <algorithm>
+#include <cstring>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "core/file_sys/romfs_reader.h"
+#include "core/settings.h"
 
 namespace FileSys {
 
+MICROPROFILE_DEFINE(RomFS_CachedRead, "FS", "RomFS Cached Read", MP_RGB(200, 160, 64));
+
+static std::size_t GetMaxCachedBlocks() {
+    return static_cast<std::size_t>(Settings::values.romfs_cache_size) * 0x100000 /
+           RomFSReader::BLOCK_SIZE;
+}
+
+struct RomFSReader::Cipher {
+    Cipher(const std::array<u8, 16>& key, const std::array<u8, 16>& ctr)
+        : decryption(key.data(), key.size(), ctr.data()) {}
+
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption decryption;
+};
+
+RomFSReader::RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
+    : is_encrypted(false), file(std::move(file)), file_offset(file_offset), data_size(data_size),
+      max_cached_blocks(GetMaxCachedBlocks()) {
+    if (data_size == 0)
+        return;
+    mapping = std::make_unique<FileUtil::MappedFileRange>(this->file, file_offset, data_size);
+    if (!mapping->IsValid()) {
+        LOG_WARNING(Service_FS, "Could not map the RomFS, reading it through the cache");
+        mapping.reset();
+    }
+}
+
+RomFSReader::RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
+                         const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
+                         std::size_t crypto_offset)
+    : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
+      crypto_offset(crypto_offset), data_size(data_size),
+      cipher(std::make_unique<Cipher>(key, ctr)), max_cached_blocks(GetMaxCachedBlocks()) {}
+
+RomFSReader::~RomFSReader() {
+    LOG_DEBUG(Service_FS, "RomFS cache: {} hits, {} misses, {} bytes decrypted", stats.hits,
+              stats.misses, stats.bytes_decrypted);
+}
+
 std::size_t RomFSReader::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
-    if (length == 0)
-        return 0; // Crypto++ does not like zero size buffer
+    if (length == 0 || offset >= data_size)
+        return 0;
+    length = std::min(length, data_size - offset);
+
+    // The mapping is never modified, so mapped reads need no lock
+    if (mapping)
+        return ReadMapped(offset, length, buffer);
+
+    MICROPROFILE_SCOPE(RomFS_CachedRead);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Large reads would only evict the cache
+    if (length > max_cached_blocks * BLOCK_SIZE / 2)
+        return ReadUncached(offset, length, buffer);
+
+    const CacheStats previous_stats = stats;
+    std::size_t read_length = 0;
+    while (read_length < length) {
+        const std::size_t position = offset + read_length;
+        const Block& block = GetBlock(position / BLOCK_SIZE);
+        const std::size_t block_offset = position % BLOCK_SIZE;
+        if (block_offset >= block.data.size())
+            break; // The host file is shorter than the RomFS
+
+        const std::size_t copy_length =
+            std::min(length - read_length, block.data.size() - block_offset);
+        std::memcpy(buffer + read_length, block.data.data() + block_offset, copy_length);
+        read_length += copy_length;
+    }
+
+    MICROPROFILE_META_CPU("RomFS cache hits", static_cast<int>(stats.hits - previous_stats.hits));
+    MICROPROFILE_META_CPU("RomFS cache misses",
+                          static_cast<int>(stats.misses - previous_stats.misses));
+    return read_length;
+}
+
+void RomFSReader::SetCacheSize(std::size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    max_cached_blocks = size / BLOCK_SIZE;
+    EvictBlocks();
+}
+
+std::size_t RomFSReader::ReadMapped(std::size_t offset, std::size_t length, u8* buffer) {
+    if (offset >= mapping->GetSize())
+        return 0; // The host file is shorter than the RomFS
+    length = std::min(length, mapping->GetSize() - offset);
+
+    // Have the host read ahead of streaming reads, as the cache would
+    if (next_mapped_offset.exchange(offset + length) == offset)
+        mapping->Prefetch(offset + length, READ_AHEAD_BLOCKS * BLOCK_SIZE);
+
+    std::memcpy(buffer, mapping->GetData() + offset, length);
+    return length;
+}
+
+std::size_t RomFSReader::ReadUncached(std::size_t offset, std::size_t length, u8* buffer) {
     file.Seek(file_offset + offset, SEEK_SET);
-    std::size_t read_length = std::min(length, data_size - offset);
-    read_length = file.ReadBytes(buffer, read_length);
-    if (is_encrypted) {
-        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
-        d.Seek(crypto_offset + offset);
-        d.ProcessData(buffer, buffer, read_length);
+    const std::size_t read_length = file.ReadBytes(buffer, length);
+    if (is_encrypted && read_length != 0) { // Crypto++ does not like zero size buffer
+        cipher->decryption.Seek(crypto_offset + offset);
+        cipher->decryption.ProcessData(buffer, buffer, read_length);
+        stats.bytes_decrypted += read_length;
     }
     return read_length;
 }
 
+const RomFSReader::Block& RomFSReader::GetBlock(std::size_t index) {
+    const auto it = block_map.find(index);
+    if (it != block_map.end()) {
+        ++stats.hits;
+        blocks.splice(blocks.begin(), blocks, it->second);
+        next_block = index + 1;
+        return blocks.front();
+    }
+
+    ++stats.misses;
+    std::size_t count = 1;
+    if (index == next_block) {
+        // Stop the read-ahead at the end of the data or at the next cached block
+        const std::size_t num_blocks = (data_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const std::size_t max_count =
+            std::min({READ_AHEAD_BLOCKS, num_blocks - index, max_cached_blocks});
+        while (count < max_count && block_map.count(index + count) == 0) {
+            ++count;
+        }
+    }
+
+    FetchBlocks(index, count);
+    next_block = index + 1;
+    return blocks.front();
+}
+
+void RomFSReader::FetchBlocks(std::size_t first, std::size_t count) {
+    const std::size_t offset = first * BLOCK_SIZE;
+    std::vector<u8> data(std::min(count * BLOCK_SIZE, data_size - offset));
+    const std::size_t read_length = ReadUncached(offset, data.size(), data.data());
+
+    // The requested block is added last, so that it is the most recently used one
+    for (std::size_t i = count; i-- > 0;) {
+        const std::size_t block_start = std::min(i * BLOCK_SIZE, read_length);
+        const std::size_t block_end = std::min(block_start + BLOCK_SIZE, read_length);
+        if (block_start == block_end && i != 0)
+            continue;
+
+        blocks.push_front({first + i, std::vector<u8>(data.begin() + block_start,
+                                                      data.begin() + block_end)});
+        block_map[first + i] = blocks.begin();
+    }
+    EvictBlocks();
+}
+
+void RomFSReader::EvictBlocks() {
+    // The most recently used block is kept even when the cache is disabled, as it is being read
+    while (blocks.size() > std::max<std::size_t>(max_cached_blocks, 1)) {
+        block_map.erase(blocks.back().index);
+        blocks.pop_back();
+    }
+}
+
 } // namespace FileSys
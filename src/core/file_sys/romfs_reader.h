@@ -1,22 +1,43 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
 
 namespace FileSys {
 
+/**
+ * Reads the RomFS of a title, decrypting it if needed. Reads go through an LRU cache of decrypted
+ * blocks, and a read continuing the previous one also fetches the blocks that follow. Plaintext
+ * RomFS are mapped into memory instead, so that reads are copies from the host's page cache.
+ * Readers are shared by the files of the RomFS, which may be read from the FS I/O worker thread.
+ * The cache size is taken from the settings when a reader is created, and the cache hits and
+ * misses of each cached read are reported to the profiler.
+ */
 class RomFSReader {
 public:
-    RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
-        : is_encrypted(false), file(std::move(file)), file_offset(file_offset),
-          data_size(data_size) {}
+    /// Size of the cached blocks, which is also the smallest read from the host file
+    static constexpr std::size_t BLOCK_SIZE = 0x10000;
+    /// Number of blocks fetched at once by sequential reads
+    static constexpr std::size_t READ_AHEAD_BLOCKS = 4;
 
+    struct CacheStats {
+        u64 hits = 0;            ///< Blocks found in the cache
+        u64 misses = 0;          ///< Blocks read from the host file by a cached read
+        u64 bytes_decrypted = 0; ///< Including the reads that bypass the cache
+    };
+
+    RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size);
     RomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
                 const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
-                std::size_t crypto_offset)
-        : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
-          crypto_offset(crypto_offset), data_size(data_size) {}
+                std::size_t crypto_offset);
+    ~RomFSReader();
 
     std::size_t GetSize() const {
         return data_size;
@@ -24,7 +45,36 @@ public:
 
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer);
 
+    /// Sets the memory used by the cached blocks, 0 disables the cache
+    void SetCacheSize(std::size_t size);
+
+    CacheStats GetCacheStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
 private:
+    struct Block {
+        std::size_t index;
+        std::vector<u8> data;
+    };
+
+    struct Cipher;
+
+    /// Copies data from the mapped file
+    std::size_t ReadMapped(std::size_t offset, std::size_t length, u8* buffer);
+
+    /// Reads and decrypts data from the host file, bypassing the cache
+    std::size_t ReadUncached(std::size_t offset, std::size_t length, u8* buffer);
+
+    /// Returns a block, fetching it if it is not cached
+    const Block& GetBlock(std::size_t index);
+
+    /// Reads consecutive blocks from the host file at once and adds them to the cache
+    void FetchBlocks(std::size_t first, std::size_t count);
+
+    void EvictBlocks();
+
     bool is_encrypted;
     FileUtil::IOFile file;
     std::array<u8, 16> key;
@@ -32,6 +82,24 @@ private:
     std::size_t file_offset;
     std::size_t crypto_offset;
     std::size_t data_size;
+    /// Kept for the lifetime of the reader, as setting up the key schedule is costly
+    std::unique_ptr<Cipher> cipher;
+
+    /// Mapping of the data of a plaintext RomFS, null if the file could not be mapped
+    std::unique_ptr<FileUtil::MappedFileRange> mapping;
+    /// Offset following the last mapped read, a read starting there is a sequential read
+    std::atomic<std::size_t> next_mapped_offset{0};
+
+    /// Guards the file, the cipher and the cache
+    mutable std::mutex mutex;
+
+    std::size_t max_cached_blocks;
+    /// Cached blocks, most recently used first
+    std::list<Block> blocks;
+    std::unordered_map<std::size_t, std::list<Block>::iterator> block_map;
+    /// The block following the last one read, a miss on it is a sequential read
+    std::size_t next_block = 0;
+    CacheStats stats;
 };
 
 } // namespace FileSys
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/directory_index.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/result.h"
@@ -18,7 +20,9 @@ namespace FileSys {
 /// Archive backend for general save data archive type (SaveData and SystemSaveData)
 class SaveDataArchive : public ArchiveBackend {
 public:
-    explicit SaveDataArchive(const std::string& mount_point_) : mount_point(mount_point_) {}
+    explicit SaveDataArchive(const std::string& mount_point_)
+        : mount_point(mount_point_),
+          directory_index(std::make_shared<DirectoryIndex>(mount_point_)) {}
 
     std::string GetName() const override {
         return "SaveDataArchive: " + mount_point;
@@ -38,6 +42,8 @@ public:
 
 protected:
     std::string mount_point;
+    /// Shared with the files opened from the archive, which may outlive it
+    std::shared_ptr<DirectoryIndex> directory_index;
 };
 
 } // namespace FileSys
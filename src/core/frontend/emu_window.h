@@ -10,6 +10,21 @@
 #include "common/common_types.h"
 #include "core/frontend/framebuffer_layout.h"
 
+/**
+ * An additional graphics context sharing its objects with the one of the EmuWindow, used by
+ * worker threads (e.g. for building shaders in the background).
+ */
+class GraphicsContext {
+public:
+    virtual ~GraphicsContext() = default;
+
+    /// Makes the graphics context current for the caller thread
+    virtual void MakeCurrent() = 0;
+
+    /// Releases the graphics context from the caller thread
+    virtual void DoneCurrent() = 0;
+};
+
 /**
  * Abstraction class used to provide an interface between emulation code and the frontend
  * (e.g. SDL, QGLWidget, GLFW, etc...).
@@ -50,6 +65,15 @@ public:
     /// Releases (dunno if this is the "right" word) the GLFW context from the caller thread
     virtual void DoneCurrent() = 0;
 
+    /**
+     * Creates a graphics context sharing its objects with the context of this window. It must be
+     * called from the thread the window context is current on.
+     * @returns the new context, or nullptr if the frontend doesn't support shared contexts
+     */
+    virtual std::unique_ptr<GraphicsContext> CreateSharedContext() {
+        return nullptr;
+    }
+
     /**
      * Signal that a touch pressed event has occurred (e.g. mouse click pressed)
      * @param framebuffer_x Framebuffer x-coordinate that was pressed
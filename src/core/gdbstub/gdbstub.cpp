@@ -393,6 +393,40 @@ static BreakpointMap& GetBreakpointMap(BreakpointType type) {
     }
 }
 
+/**
+ * Updates the pages of the memory watched for read and write breakpoints, so that only the pages
+ * still holding one of them trap accesses.
+ *
+ * @param addr Address of the breakpoint added or removed.
+ * @param len Length of the breakpoint added or removed.
+ */
+static void UpdateWatchedPages(VAddr addr, u32 len) {
+    if (len == 0) {
+        return;
+    }
+
+    auto HasWatchpoint = [](const BreakpointMap& p, VAddr page_addr) {
+        const auto end = p.lower_bound(page_addr + Memory::PAGE_SIZE);
+        return std::any_of(p.begin(), end, [page_addr](const auto& bp) {
+            return bp.second.addr + bp.second.len > page_addr;
+        });
+    };
+
+    Memory::PageTable& page_table =
+        Core::System::GetInstance().Kernel().GetCurrentProcess()->vm_manager.page_table;
+    const VAddr first_page = addr & ~Memory::PAGE_MASK;
+    const VAddr last_page = (addr + len - 1) & ~Memory::PAGE_MASK;
+    for (VAddr page_addr = first_page;; page_addr += Memory::PAGE_SIZE) {
+        const bool watched = HasWatchpoint(breakpoints_read, page_addr) ||
+                             HasWatchpoint(breakpoints_write, page_addr);
+        Core::System::GetInstance().Memory().SetPagesWatched(page_table, page_addr,
+                                                            Memory::PAGE_SIZE, watched);
+        if (page_addr == last_page) {
+            break;
+        }
+    }
+}
+
 /**
  * Remove the breakpoint from the given address of the specified type.
  *
@@ -416,7 +450,12 @@ static void RemoveBreakpoint(BreakpointType type, VAddr addr) {
             bp->second.inst.data(), bp->second.inst.size());
         Core::CPU().ClearInstructionCache();
     }
+    const u32 len = bp->second.len;
     p.erase(addr);
+
+    if (type != BreakpointType::Execute) {
+        UpdateWatchedPages(addr, len);
+    }
 }
 
 BreakpointAddress GetNextBreakpointFromAddress(VAddr addr, BreakpointType type) {
@@ -472,6 +511,25 @@ bool CheckBreakpoint(VAddr addr, BreakpointType type) {
     return false;
 }
 
+bool CheckWatchpoint(VAddr addr, u32 size, BreakpointType type) {
+    if (!IsConnected()) {
+        return false;
+    }
+
+    const BreakpointMap& p = GetBreakpointMap(type);
+    const auto end = p.lower_bound(addr + size);
+    for (auto bp = p.begin(); bp != end; ++bp) {
+        if (bp->second.active && bp->second.addr + bp->second.len > addr) {
+            LOG_DEBUG(Debug_GDBStub, "Found watchpoint type {} @ {:08x}, range: {:08x} - {:08x}",
+                      static_cast<int>(type), addr, bp->second.addr,
+                      bp->second.addr + bp->second.len);
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * Send packet to gdb client.
  *
@@ -934,6 +992,10 @@ static bool CommitBreakpoint(BreakpointType type, VAddr addr, u32 len) {
     }
     p.insert({addr, breakpoint});
 
+    if (type != BreakpointType::Execute) {
+        UpdateWatchedPages(addr, len);
+    }
+
     LOG_DEBUG(Debug_GDBStub, "gdb: added {} breakpoint: {:08x} bytes at {:08x}\n",
               static_cast<int>(type), breakpoint.len, breakpoint.addr);
 
@@ -80,6 +80,15 @@ BreakpointAddress GetNextBreakpointFromAddress(VAddr addr, GDBStub::BreakpointTy
  */
 bool CheckBreakpoint(VAddr addr, GDBStub::BreakpointType type);
 
+/**
+ * Check if a memory access hits a read or write breakpoint covering any of its bytes.
+ *
+ * @param addr Address of the access.
+ * @param size Size of the access in bytes.
+ * @param type Type of breakpoint.
+ */
+bool CheckWatchpoint(VAddr addr, u32 size, GDBStub::BreakpointType type);
+
 // If set to true, the CPU will halt at the beginning of the next CPU loop.
 bool GetCpuHaltFlag();
 
@@ -253,4 +253,18 @@ void MappedBuffer::Write(const void* src_buffer, std::size_t offset, std::size_t
     memory->WriteBlock(*process, address + static_cast<VAddr>(offset), src_buffer, size);
 }
 
+bool MappedBuffer::GetHostSpans(std::size_t offset, std::size_t size, bool write,
+                                Memory::ScatterList& spans) {
+    ASSERT(perms & (write ? IPC::W : IPC::R));
+    ASSERT(offset + size <= this->size);
+    return memory->GetHostSpans(*process, address + static_cast<VAddr>(offset), size, write,
+                                spans);
+}
+
+void MappedBuffer::HostSpansWritten(std::size_t offset, std::size_t size) {
+    ASSERT(perms & IPC::W);
+    ASSERT(offset + size <= this->size);
+    memory->HostSpansWritten(*process, address + static_cast<VAddr>(offset), size);
+}
+
 } // namespace Kernel
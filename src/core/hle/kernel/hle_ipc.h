@@ -16,15 +16,12 @@
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/server_session.h"
+#include "core/memory.h"
 
 namespace Service {
 class ServiceFrameworkBase;
 }
 
-namespace Memory {
-class MemorySystem;
-}
-
 namespace Kernel {
 
 class HandleTable;
@@ -104,6 +101,16 @@ public:
     // interface for service
     void Read(void* dest_buffer, std::size_t offset, std::size_t size);
     void Write(const void* src_buffer, std::size_t offset, std::size_t size);
+
+    /**
+     * Resolves part of the buffer to the host memory backing it, for services that read or write
+     * large amounts of data in place.
+     * @returns false if it is not all backed by memory, in which case Read and Write must be used
+     */
+    bool GetHostSpans(std::size_t offset, std::size_t size, bool write,
+                      Memory::ScatterList& spans);
+    /// Must be called on the emulator thread once the spans got with write set have been written
+    void HostSpansWritten(std::size_t offset, std::size_t size);
     std::size_t GetSize() const {
         return size;
     }
@@ -54,6 +54,7 @@ void VMManager::Reset() {
 
     page_table.pointers.fill(nullptr);
     page_table.attributes.fill(Memory::PageType::Unmapped);
+    page_table.tracked_pointers.clear();
 
     UpdatePageTableForVMA(initial_vma);
 }
@@ -4,10 +4,15 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -42,6 +47,11 @@ constexpr u8 VARIATION_SYSTEM = 0x02;
 constexpr u32 TID_HIGH_UPDATE = 0x0004000E;
 constexpr u32 TID_HIGH_DLC = 0x0004008C;
 
+/// Size of the reads from the CIA file when installing it, and of the writes of its contents
+constexpr std::size_t INSTALL_CHUNK_SIZE = 0x100000;
+/// Content data read ahead of the install workers, which bounds the memory an install uses
+constexpr std::size_t INSTALL_MAX_PENDING = 32 * INSTALL_CHUNK_SIZE;
+
 struct TitleInfo {
     u64_le tid;
     u64_le size;
@@ -196,6 +206,163 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
     return MakeResult<std::size_t>(length);
 }
 
+ResultCode CIAFile::InstallContents(FileUtil::IOFile& file,
+                                    const std::function<ProgressCallback>& update_callback) {
+    // A malformed CIA may end before its title metadata was loaded
+    if (install_state != CIAInstallState::TMDLoaded) {
+        LOG_ERROR(Service_AM, "Installing the contents of a CIA without title metadata");
+        return ResultCode(ErrCodes::InvalidCIAHeader, ErrorModule::AM,
+                          ErrorSummary::InvalidArgument, ErrorLevel::Permanent);
+    }
+
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+    const std::size_t content_count = tmd.GetContentCount();
+
+    struct Content {
+        FileUtil::IOFile file;
+        CryptoPP::SHA256 sha;
+        bool encrypted = false;
+        /// Whether a worker owns the content, which keeps its chunks processed in order
+        bool busy = false;
+        std::deque<std::vector<u8>> chunks;
+    };
+    std::vector<Content> contents(content_count);
+    for (u16 i = 0; i < content_count; i++) {
+        Content& content = contents[i];
+        content.file =
+            FileUtil::IOFile(GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update), "wb");
+        if (!content.file.IsOpen())
+            return FileSys::ERROR_INSUFFICIENT_SPACE;
+        content.encrypted = tmd.GetContentTypeByIndex(i) & FileSys::TMDContentTypeFlag::Encrypted;
+    }
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable space_cv;
+    std::size_t pending = 0;
+    bool reading_done = false;
+    bool failed = false;
+
+    const auto worker = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            auto ready = contents.end();
+            work_cv.wait(lock, [&] {
+                ready = std::find_if(contents.begin(), contents.end(), [](const Content& content) {
+                    return !content.busy && !content.chunks.empty();
+                });
+                return ready != contents.end() || reading_done;
+            });
+            // Chunks left once reading is done belong to contents owned by other workers
+            if (ready == contents.end())
+                return;
+
+            Content& content = *ready;
+            const std::size_t index = static_cast<std::size_t>(ready - contents.begin());
+            content.busy = true;
+            while (!content.chunks.empty()) {
+                std::vector<u8> chunk = std::move(content.chunks.front());
+                content.chunks.pop_front();
+                lock.unlock();
+
+                if (content.encrypted) {
+                    decryption_state->content[index].ProcessData(chunk.data(), chunk.data(),
+                                                                 chunk.size());
+                }
+                content.sha.Update(chunk.data(), chunk.size());
+                const bool write_ok =
+                    content.file.WriteBytes(chunk.data(), chunk.size()) == chunk.size();
+
+                lock.lock();
+                pending -= chunk.size();
+                if (write_ok) {
+                    content_written[index] += chunk.size();
+                } else {
+                    failed = true;
+                }
+                space_cv.notify_one();
+            }
+            content.busy = false;
+        }
+    };
+
+    const std::size_t num_workers = std::max<std::size_t>(
+        1, std::min<std::size_t>(std::thread::hardware_concurrency(), content_count));
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < num_workers; i++)
+        workers.emplace_back(worker);
+
+    // Contents are stored one after the other, so reading them in order reads the file sequentially
+    const u64 total_size = file.GetSize();
+    bool read_failed = false;
+    bool aborted = false;
+    for (u16 i = 0; i < content_count && !aborted; i++) {
+        const u64 content_offset = container.GetContentOffset(i);
+        const u64 content_size = container.GetContentSize(i);
+        read_failed = aborted = !file.Seek(content_offset, SEEK_SET);
+
+        for (u64 pos = 0; pos < content_size && !aborted;) {
+            const std::size_t chunk_size =
+                static_cast<std::size_t>(std::min<u64>(INSTALL_CHUNK_SIZE, content_size - pos));
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                space_cv.wait(lock, [&] {
+                    return failed || pending + chunk_size <= INSTALL_MAX_PENDING;
+                });
+                if (failed) {
+                    aborted = true;
+                    break;
+                }
+            }
+
+            std::vector<u8> chunk(chunk_size);
+            if (file.ReadBytes(chunk.data(), chunk_size) != chunk_size) {
+                read_failed = aborted = true;
+                break;
+            }
+            pos += chunk_size;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending += chunk_size;
+                contents[i].chunks.push_back(std::move(chunk));
+            }
+            work_cv.notify_one();
+
+            if (update_callback)
+                update_callback(content_offset + pos, total_size);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reading_done = true;
+    }
+    work_cv.notify_all();
+    for (auto& thread : workers)
+        thread.join();
+
+    if (read_failed)
+        return FileSys::ERROR_NOT_FOUND;
+    if (failed)
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+
+    // A content failing verification is left incomplete, so that closing aborts the install
+    for (u16 i = 0; i < content_count; i++) {
+        std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+        contents[i].sha.Final(hash.data());
+        if (hash != tmd.GetContentHashByIndex(i)) {
+            LOG_ERROR(Service_AM, "Hash mismatch in content {} ({:08x})", i,
+                      tmd.GetContentIDByIndex(i));
+            content_written[i] = 0;
+            return ResultCode(ErrorDescription::NotAuthorized, ErrorModule::AM,
+                              ErrorSummary::WrongArgument, ErrorLevel::Permanent);
+        }
+    }
+
+    return RESULT_SUCCESS;
+}
+
 ResultVal<std::size_t> CIAFile::Write(u64 offset, std::size_t length, bool flush,
                                       const u8* buffer) {
     written += length;
@@ -323,7 +490,9 @@ bool CIAFile::Close() const {
     return true;
 }
 
-void CIAFile::Flush() const {}
+bool CIAFile::Flush() const {
+    return true;
+}
 
 InstallStatus InstallCIA(const std::string& path,
                          std::function<ProgressCallback>&& update_callback) {
@@ -354,21 +523,19 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
-        std::array<u8, 0x10000> buffer;
-        std::size_t total_bytes_read = 0;
-        while (total_bytes_read != file.GetSize()) {
-            std::size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
-            auto result = installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
-                                            static_cast<u8*>(buffer.data()));
-
-            if (update_callback)
-                update_callback(total_bytes_read, file.GetSize());
-            if (result.Failed()) {
-                LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
-                          result.Code().raw);
-                return InstallStatus::ErrorAborted;
-            }
-            total_bytes_read += bytes_read;
+        // Everything before the contents is small and sets up the install, the contents
+        // themselves go through the pipelined path
+        std::vector<u8> header(static_cast<std::size_t>(container.GetContentOffset()));
+        if (file.ReadBytes(header.data(), header.size()) != header.size())
+            return InstallStatus::ErrorInvalid;
+
+        ResultCode result = installFile.Write(0, header.size(), true, header.data()).Code();
+        if (result.IsSuccess())
+            result = installFile.InstallContents(file, update_callback);
+        if (result.IsError()) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
+                      result.raw);
+            return InstallStatus::ErrorAborted;
         }
         installFile.Close();
 
@@ -1129,7 +1296,9 @@ public:
     bool Close() const override {
         return false;
     }
-    void Flush() const override {}
+    bool Flush() const override {
+        return true;
+    }
 
 private:
     std::shared_ptr<Service::FS::File> file;
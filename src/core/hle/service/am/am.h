@@ -20,6 +20,10 @@ namespace Core {
 class System;
 }
 
+namespace FileUtil {
+class IOFile;
+}
+
 namespace Service::FS {
 enum class MediaType : u32;
 }
@@ -71,12 +75,23 @@ public:
     ResultCode WriteTicket();
     ResultCode WriteTitleMetadata();
     ResultVal<std::size_t> WriteContentData(u64 offset, std::size_t length, const u8* buffer);
+
+    /**
+     * Installs the contents straight from a CIA file, once everything before them was written.
+     * The file is read sequentially on the calling thread while worker threads decrypt, verify
+     * and write out the contents, each content in order and distinct contents in parallel.
+     * @param file the CIA file being installed
+     * @param update_callback callback function called on the calling thread as data is read
+     * @returns ResultCode an error if a content could not be read, written or verified
+     */
+    ResultCode InstallContents(FileUtil::IOFile& file,
+                               const std::function<ProgressCallback>& update_callback);
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override;
-    void Flush() const override;
+    bool Flush() const override;
 
 private:
     // Whether it's installing an update, and what step of installation it is at
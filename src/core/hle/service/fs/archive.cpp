@@ -13,6 +13,8 @@
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "core/core.h"
+#include "core/core_timing.h"
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/archive_ncch.h"
@@ -27,6 +29,7 @@
 #include "core/file_sys/file_backend.h"
 #include "core/hle/result.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hle/service/fs/io_worker.h"
 
 namespace Service::FS {
 
@@ -58,8 +61,30 @@ ResultVal<ArchiveHandle> ArchiveManager::OpenArchive(ArchiveIdCode id_code,
 ResultCode ArchiveManager::CloseArchive(ArchiveHandle handle) {
     if (handle_map.erase(handle) == 0)
         return FileSys::ERR_INVALID_ARCHIVE_HANDLE;
-    else
-        return RESULT_SUCCESS;
+
+    // Let the queued writes land before the unmount writes out the buffers
+    system.FSIOWorker().WaitIdle();
+    FlushOpenFiles(handle);
+    return RESULT_SUCCESS;
+}
+
+void ArchiveManager::FlushOpenFiles(ArchiveHandle archive_handle) {
+    auto itr = open_files.begin();
+    while (itr != open_files.end()) {
+        std::shared_ptr<File> file = itr->file.lock();
+        if (!file) {
+            itr = open_files.erase(itr);
+            continue;
+        }
+        if (archive_handle == 0 || itr->archive_handle == archive_handle)
+            file->backend->Flush();
+        ++itr;
+    }
+}
+
+void ArchiveManager::FlushEventCallback(s64 cycles_late) {
+    FlushOpenFiles();
+    system.CoreTiming().ScheduleEvent(msToCycles(1000) - cycles_late, flush_event);
 }
 
 // TODO(yuriks): This might be what the fs:REG service is for. See the Register/Unregister calls in
@@ -91,6 +116,8 @@ ArchiveManager::OpenFileFromArchive(ArchiveHandle archive_handle, const FileSys:
         return std::make_tuple(backend.Code(), open_timeout_ns);
 
     auto file = std::shared_ptr<File>(new File(system, std::move(backend).Unwrap(), path));
+    if (mode.write_flag)
+        open_files.push_back({archive_handle, file});
     return std::make_tuple(MakeResult<std::shared_ptr<File>>(std::move(file)), open_timeout_ns);
 }
 
@@ -354,6 +381,11 @@ void ArchiveManager::RegisterSelfNCCH(Loader::AppLoader& app_loader) {
 
 ArchiveManager::ArchiveManager(Core::System& system) : system(system) {
     RegisterArchiveTypes();
+
+    flush_event = system.CoreTiming().RegisterEvent(
+        "ArchiveManager::flush_event",
+        [this](u64 /*userdata*/, s64 cycles_late) { FlushEventCallback(cycles_late); });
+    system.CoreTiming().ScheduleEvent(msToCycles(1000), flush_event);
 }
 
 } // namespace Service::FS
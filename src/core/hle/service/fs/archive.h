@@ -26,6 +26,7 @@ class AppLoader;
 
 namespace Core {
 class System;
+struct TimingEventType;
 }
 
 namespace Service::FS {
@@ -67,7 +68,7 @@ public:
                                          u64 program_id);
 
     /**
-     * Closes an archive
+     * Closes an archive, writing out the data buffered by the files opened from it
      * @param handle Handle to the archive to close
      */
     ResultCode CloseArchive(ArchiveHandle handle);
@@ -249,6 +250,16 @@ private:
 
     ArchiveBackend* GetArchive(ArchiveHandle handle);
 
+    /**
+     * Writes out the data buffered by the files opened for writing, and forgets the files that
+     * were released since
+     * @param archive_handle Only flushes the files opened from this archive, unless it is 0
+     */
+    void FlushOpenFiles(ArchiveHandle archive_handle = 0);
+
+    /// Periodically flushes the open files, so that buffered writes reach the host in time
+    void FlushEventCallback(s64 cycles_late);
+
     /**
      * Map of registered archives, identified by id code. Once an archive is registered here, it is
      * never removed until UnregisterArchiveTypes is called.
@@ -260,6 +271,14 @@ private:
      */
     std::unordered_map<ArchiveHandle, std::unique_ptr<ArchiveBackend>> handle_map;
     ArchiveHandle next_handle = 1;
+
+    struct OpenFile {
+        ArchiveHandle archive_handle;
+        std::weak_ptr<File> file;
+    };
+    /// Files opened for writing, which may hold buffered writes
+    std::vector<OpenFile> open_files;
+    Core::TimingEventType* flush_event;
 };
 
 } // namespace Service::FS
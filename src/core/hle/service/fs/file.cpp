@@ -12,6 +12,7 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/service/fs/file.h"
+#include "core/hle/service/fs/io_worker.h"
 
 namespace Service::FS {
 
@@ -50,33 +51,45 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     // This file session might have a specific offset from where to start reading, apply it.
     offset += file->offset;
 
-    if (offset + length > backend->GetSize()) {
-        LOG_ERROR(Service_FS,
-                  "Reading from out of bounds offset=0x{:x} length=0x{:08X} file_size=0x{:x}",
-                  offset, length, backend->GetSize());
+    const u32 buffer_id = buffer.GetId();
+    auto data = std::make_shared<std::vector<u8>>();
+    auto spans = std::make_shared<Memory::ScatterList>();
+    // Read straight into guest memory when possible, saving a heap allocation and a copy
+    if (length > buffer.GetSize() || !buffer.GetHostSpans(0, length, true, *spans)) {
+        data->resize(length);
+        *spans = {{data->data(), data->size()}};
     }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
-    if (read.Failed()) {
-        rb.Push(read.Code());
-        rb.Push<u32>(0);
-    } else {
-        buffer.Write(data.data(), 0, *read);
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(static_cast<u32>(*read));
-    }
-    rb.PushMappedBuffer(buffer);
-
-    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
-    ctx.SleepClientThread("file::read", read_timeout_ns,
-                          [](std::shared_ptr<Kernel::Thread> /*thread*/,
-                             Kernel::HLERequestContext& /*ctx*/,
-                             Kernel::ThreadWakeupReason /*reason*/) {
-                              // Nothing to do here
-                          });
+    auto read = std::make_shared<ResultVal<std::size_t>>(MakeResult<std::size_t>(0));
+    auto self = std::static_pointer_cast<File>(shared_from_this());
+    RunIO(ctx, "file::read", backend->GetReadDelayNs(length),
+          [self, offset, length, spans, read] {
+              // Checked with the I/O, as the queued writes may still grow the file
+              const u64 file_size = self->backend->GetSize();
+              if (offset + length > file_size) {
+                  LOG_ERROR(Service_FS,
+                            "Reading from out of bounds offset=0x{:x} length=0x{:08X} "
+                            "file_size=0x{:x}",
+                            offset, length, file_size);
+              }
+              *read = self->backend->ReadScatter(offset, *spans);
+          },
+          [buffer_id, length, data, read](Kernel::HLERequestContext& ctx) {
+              Kernel::MappedBuffer& buffer = ctx.GetMappedBuffer(buffer_id);
+              if (data->empty())
+                  buffer.HostSpansWritten(0, length);
+              IPC::RequestBuilder rb(ctx, 0x0802, 2, 2);
+              if (read->Failed()) {
+                  rb.Push(read->Code());
+                  rb.Push<u32>(0);
+              } else {
+                  if (!data->empty())
+                      buffer.Write(data->data(), 0, **read);
+                  rb.Push(RESULT_SUCCESS);
+                  rb.Push<u32>(static_cast<u32>(**read));
+              }
+              rb.PushMappedBuffer(buffer);
+          });
 }
 
 void File::Write(Kernel::HLERequestContext& ctx) {
@@ -88,29 +101,43 @@ void File::Write(Kernel::HLERequestContext& ctx) {
     LOG_TRACE(Service_FS, "Write {}: offset=0x{:x} length={}, flush=0x{:x}", GetName(), offset,
               length, flush);
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-
     const FileSessionSlot* file = GetSessionData(ctx.Session());
 
     // Subfiles can not be written to
     if (file->subfile) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
         rb.Push(FileSys::ERROR_UNSUPPORTED_OPEN_FLAGS);
         rb.Push<u32>(0);
         rb.PushMappedBuffer(buffer);
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<std::size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
-    if (written.Failed()) {
-        rb.Push(written.Code());
-        rb.Push<u32>(0);
-    } else {
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(static_cast<u32>(*written));
+    const u32 buffer_id = buffer.GetId();
+    auto data = std::make_shared<std::vector<u8>>();
+    auto spans = std::make_shared<Memory::ScatterList>();
+    if (!buffer.GetHostSpans(0, length, false, *spans)) {
+        data->resize(length);
+        buffer.Read(data->data(), 0, data->size());
+        *spans = {{data->data(), data->size()}};
     }
-    rb.PushMappedBuffer(buffer);
+
+    auto written = std::make_shared<ResultVal<std::size_t>>(MakeResult<std::size_t>(0));
+    auto self = std::static_pointer_cast<File>(shared_from_this());
+    RunIO(ctx, "file::write", 0,
+          [self, offset, flush, spans, data, written] {
+              *written = self->backend->WriteGather(offset, flush != 0, *spans);
+          },
+          [buffer_id, written](Kernel::HLERequestContext& ctx) {
+              IPC::RequestBuilder rb(ctx, 0x0803, 2, 2);
+              if (written->Failed()) {
+                  rb.Push(written->Code());
+                  rb.Push<u32>(0);
+              } else {
+                  rb.Push(RESULT_SUCCESS);
+                  rb.Push<u32>(static_cast<u32>(**written));
+              }
+              rb.PushMappedBuffer(ctx.GetMappedBuffer(buffer_id));
+          });
 }
 
 void File::GetSize(Kernel::HLERequestContext& ctx) {
@@ -138,6 +165,7 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
     }
 
     file->size = size;
+    system.FSIOWorker().WaitIdle();
     backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
 }
@@ -150,9 +178,12 @@ void File::Close(Kernel::HLERequestContext& ctx) {
         LOG_WARNING(Service_FS, "Closing File backend but {} clients still connected",
                     connected_sessions.size());
 
+    system.FSIOWorker().WaitIdle();
+    // Buffered writes that could not be written out are reported when the file is closed
+    const bool flushed = backend->Flush();
     backend->Close();
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
-    rb.Push(RESULT_SUCCESS);
+    rb.Push(flushed ? RESULT_SUCCESS : FileSys::ERROR_INSUFFICIENT_SPACE);
 }
 
 void File::Flush(Kernel::HLERequestContext& ctx) {
@@ -168,8 +199,8 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    backend->Flush();
-    rb.Push(RESULT_SUCCESS);
+    system.FSIOWorker().WaitIdle();
+    rb.Push(backend->Flush() ? RESULT_SUCCESS : FileSys::ERROR_INSUFFICIENT_SPACE);
 }
 
 void File::SetPriority(Kernel::HLERequestContext& ctx) {
@@ -206,7 +237,7 @@ void File::OpenLinkFile(Kernel::HLERequestContext& ctx) {
 
     slot->priority = original_file->priority;
     slot->offset = 0;
-    slot->size = backend->GetSize();
+    slot->size = GetBackendSize();
     slot->subfile = false;
 
     rb.Push(RESULT_SUCCESS);
@@ -258,6 +289,30 @@ void File::OpenSubFile(Kernel::HLERequestContext& ctx) {
     rb.PushMoveObjects(std::get<std::shared_ptr<ClientSession>>(sessions));
 }
 
+void File::RunIO(Kernel::HLERequestContext& ctx, const std::string& reason, u64 delay_ns,
+                 std::function<void()> io,
+                 std::function<void(Kernel::HLERequestContext&)> respond) {
+    if (!backend->SupportsBackgroundIO()) {
+        io();
+        respond(ctx);
+        if (delay_ns == 0)
+            return;
+        ctx.SleepClientThread(reason, std::chrono::nanoseconds(delay_ns),
+                              [](std::shared_ptr<Kernel::Thread> /*thread*/,
+                                 Kernel::HLERequestContext& /*ctx*/,
+                                 Kernel::ThreadWakeupReason /*reason*/) {
+                                  // Nothing to do here
+                              });
+        return;
+    }
+
+    auto event = ctx.SleepClientThread(
+        reason, std::chrono::nanoseconds(-1),
+        [respond](std::shared_ptr<Kernel::Thread> /*thread*/, Kernel::HLERequestContext& ctx,
+                  Kernel::ThreadWakeupReason /*reason*/) { respond(ctx); });
+    system.FSIOWorker().Submit(delay_ns, std::move(io), [event] { event->Signal(); });
+}
+
 std::shared_ptr<Kernel::ClientSession> File::Connect() {
     auto sessions = system.Kernel().CreateSessionPair(GetName());
     auto server = std::get<std::shared_ptr<Kernel::ServerSession>>(sessions);
@@ -266,12 +321,18 @@ std::shared_ptr<Kernel::ClientSession> File::Connect() {
     FileSessionSlot* slot = GetSessionData(server);
     slot->priority = 0;
     slot->offset = 0;
-    slot->size = backend->GetSize();
+    slot->size = GetBackendSize();
     slot->subfile = false;
 
     return std::get<std::shared_ptr<Kernel::ClientSession>>(sessions);
 }
 
+u64 File::GetBackendSize() {
+    // The worker thread may be seeking the host file
+    system.FSIOWorker().WaitIdle();
+    return backend->GetSize();
+}
+
 std::size_t File::GetSessionFileOffset(std::shared_ptr<Kernel::ServerSession> session) {
     const FileSessionSlot* slot = GetSessionData(session);
     ASSERT(slot);
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <string>
 #include "core/file_sys/archive_backend.h"
 #include "core/hle/service/service.h"
 
@@ -59,6 +61,19 @@ private:
     void OpenLinkFile(Kernel::HLERequestContext& ctx);
     void OpenSubFile(Kernel::HLERequestContext& ctx);
 
+    /**
+     * Runs the host I/O of a request and writes its response, putting the client thread to sleep
+     * for the emulated duration of the request. The I/O runs on the FS I/O worker when the backend
+     * allows it, in which case the response is written when the thread wakes up.
+     * @param io Host I/O of the request
+     * @param respond Writes the whole response to the request
+     */
+    void RunIO(Kernel::HLERequestContext& ctx, const std::string& reason, u64 delay_ns,
+               std::function<void()> io, std::function<void(Kernel::HLERequestContext&)> respond);
+
+    /// Returns the size of the backend once the queued I/O is done with it
+    u64 GetBackendSize();
+
     Core::System& system;
 };
 
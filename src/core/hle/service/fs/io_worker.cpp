@@ -0,0 +1,92 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/thread.h"
+#include "core/core_timing.h"
+#include "core/hle/service/fs/io_worker.h"
+
+namespace Service::FS {
+
+IOWorker::IOWorker(Core::Timing& timing) : timing(timing) {
+    io_event = timing.RegisterEvent("FS::IOWorker::io_event",
+                                    [this](u64 id, s64 /*cycles_late*/) { Finish(id, true); });
+    delay_event = timing.RegisterEvent(
+        "FS::IOWorker::delay_event", [this](u64 id, s64 /*cycles_late*/) { Finish(id, false); });
+    worker_thread = std::thread(&IOWorker::WorkerLoop, this);
+}
+
+IOWorker::~IOWorker() {
+    // Queued jobs still run, so that no write to the save data is lost
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    job_cv.notify_one();
+    worker_thread.join();
+
+    timing.RemoveNormalAndThreadsafeEvent(io_event);
+    timing.RemoveNormalAndThreadsafeEvent(delay_event);
+}
+
+void IOWorker::Submit(u64 delay_ns, std::function<void()> job, std::function<void()> callback) {
+    const u64 id = next_id++;
+    Request& request = requests[id];
+    request.callback = std::move(callback);
+    if (delay_ns == 0) {
+        request.delay_done = true;
+    } else {
+        timing.ScheduleEvent(nsToCycles(delay_ns), delay_event, id);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.emplace_back(id, std::move(job));
+    }
+    job_cv.notify_one();
+}
+
+void IOWorker::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_cv.wait(lock, [this] { return !busy && jobs.empty(); });
+}
+
+void IOWorker::Finish(u64 id, bool io) {
+    const auto it = requests.find(id);
+    ASSERT(it != requests.end());
+    Request& request = it->second;
+    (io ? request.io_done : request.delay_done) = true;
+    if (!request.io_done || !request.delay_done)
+        return;
+
+    const auto callback = std::move(request.callback);
+    requests.erase(it);
+    callback();
+}
+
+void IOWorker::WorkerLoop() {
+    Common::SetCurrentThreadName("FS I/O Worker");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        job_cv.wait(lock, [this] { return stop || !jobs.empty(); });
+        if (jobs.empty())
+            return;
+
+        auto [id, job] = std::move(jobs.front());
+        jobs.pop_front();
+        busy = true;
+        lock.unlock();
+
+        job();
+        timing.ScheduleEventThreadsafe(0, io_event, id);
+
+        lock.lock();
+        busy = false;
+        if (jobs.empty())
+            idle_cv.notify_all();
+    }
+}
+
+} // namespace Service::FS
@@ -0,0 +1,74 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include "common/common_types.h"
+
+namespace Core {
+class Timing;
+struct TimingEventType;
+} // namespace Core
+
+namespace Service::FS {
+
+/**
+ * Runs the host I/O of FS requests on a worker thread, so that slow disks do not stall emulation
+ * while the requesting guest thread sleeps. Jobs run one at a time, in the order they were
+ * submitted. A request completes on the emulation thread once its job has run and its emulated
+ * duration has elapsed, whichever comes last.
+ */
+class IOWorker {
+public:
+    explicit IOWorker(Core::Timing& timing);
+    ~IOWorker();
+
+    /**
+     * Queues a request.
+     * @param delay_ns Emulated duration of the request
+     * @param job Host I/O of the request, run on the worker thread
+     * @param callback Run on the emulation thread when the request completes
+     */
+    void Submit(u64 delay_ns, std::function<void()> job, std::function<void()> callback);
+
+    /// Blocks until all the queued jobs have run, for requests that are handled synchronously
+    void WaitIdle();
+
+private:
+    struct Request {
+        std::function<void()> callback;
+        bool io_done = false;
+        bool delay_done = false;
+    };
+
+    /// Records the end of the job or of the delay of a request, completing it if both are over
+    void Finish(u64 id, bool io);
+
+    void WorkerLoop();
+
+    Core::Timing& timing;
+    Core::TimingEventType* io_event;
+    Core::TimingEventType* delay_event;
+
+    /// Requests in flight, only accessed by the emulation thread
+    std::unordered_map<u64, Request> requests;
+    u64 next_id = 0;
+
+    std::mutex mutex;
+    std::condition_variable job_cv;
+    std::condition_variable idle_cv;
+    std::deque<std::pair<u64, std::function<void()>>> jobs;
+    bool busy = false;
+    bool stop = false;
+    std::thread worker_thread;
+};
+
+} // namespace Service::FS
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <cryptopp/aes.h>
@@ -51,6 +52,10 @@ AESKey HexToKey(const std::string& hex) {
     return key;
 }
 
+AESKey MakeNormalKey(const AESKey& x, const AESKey& y) {
+    return Lrot128(Add128(Xor128(Lrot128(x, 2), y), generator_constant), 87);
+}
+
 struct KeySlot {
     std::optional<AESKey> x;
     std::optional<AESKey> y;
@@ -72,7 +77,7 @@ struct KeySlot {
 
     void GenerateNormalKey() {
         if (x && y) {
-            normal = Lrot128(Add128(Xor128(Lrot128(*x, 2), *y), generator_constant), 87);
+            normal = MakeNormalKey(*x, *y);
         } else {
             normal = {};
         }
@@ -440,14 +445,14 @@ void LoadPresetKeys() {
 } // namespace
 
 void InitKeys() {
-    static bool initialized = false;
-    if (initialized)
-        return;
-    LoadBootromKeys();
-    LoadNativeFirmKeysOld3DS();
-    LoadNativeFirmKeysNew3DS();
-    LoadPresetKeys();
-    initialized = true;
+    // Titles may be loaded by several threads at once, e.g. when populating the game list
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        LoadBootromKeys();
+        LoadNativeFirmKeysOld3DS();
+        LoadNativeFirmKeysNew3DS();
+        LoadPresetKeys();
+    });
 }
 
 void SetKeyX(std::size_t slot_id, const AESKey& key) {
@@ -470,6 +475,14 @@ AESKey GetNormalKey(std::size_t slot_id) {
     return key_slots.at(slot_id).normal.value_or(AESKey{});
 }
 
+std::optional<AESKey> GenerateNormalKey(std::size_t slot_id, const AESKey& key_y) {
+    const std::optional<AESKey>& x = key_slots.at(slot_id).x;
+    if (!x) {
+        return {};
+    }
+    return MakeNormalKey(*x, key_y);
+}
+
 void SelectCommonKeyIndex(u8 index) {
     key_slots[KeySlotID::TicketCommonKey].SetKeyY(common_key_y_slots.at(index));
 }
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cstddef>
+#include <optional>
 #include "common/common_types.h"
 
 namespace HW::AES {
@@ -47,6 +48,13 @@ void SetNormalKey(std::size_t slot_id, const AESKey& key);
 bool IsNormalKeyAvailable(std::size_t slot_id);
 AESKey GetNormalKey(std::size_t slot_id);
 
+/**
+ * Generates the normal key of a slot for the given KeyY without changing the slot, so that it can
+ * be called from several threads at once.
+ * @returns the normal key, or nothing if the KeyX of the slot is missing
+ */
+std::optional<AESKey> GenerateNormalKey(std::size_t slot_id, const AESKey& key_y);
+
 void SelectCommonKeyIndex(u8 index);
 
 } // namespace HW::AES
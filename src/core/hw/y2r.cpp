@@ -81,7 +81,7 @@ static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u
 template <std::size_t N>
 static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuffer& buf,
                         std::size_t amount_of_data) {
-    const u8* input = memory.GetPointer(buf.address);
+    const u8* input = memory.GetReadPointer(buf.address);
 
     std::size_t output_unit = buf.transfer_unit / N;
     ASSERT(amount_of_data % output_unit == 0);
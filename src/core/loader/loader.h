@@ -5,6 +5,7 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <initializer_list>
 #include <memory>
 #include <optional>
@@ -82,6 +83,19 @@ constexpr u32 MakeMagic(char a, char b, char c, char d) {
     return a | b << 8 | c << 16 | d << 24;
 }
 
+/// Outcome of checking the content of an application against the hashes stored in it
+struct VerificationResult {
+    bool headers_good = true;   ///< Whether the superblock hashes and the IVFC header match
+    u32 bad_exefs_sections = 0; ///< ExeFS sections that do not match their hash
+    u64 bad_romfs_blocks = 0;   ///< Blocks of any IVFC level that do not match their hash
+    u64 bytes_hashed = 0;
+    bool stopped = false; ///< Set if the check was stopped before it was done
+
+    bool IsGood() const {
+        return headers_good && bad_exefs_sections == 0 && bad_romfs_blocks == 0;
+    }
+};
+
 /// Interface for loading an application
 class AppLoader : NonCopyable {
 public:
@@ -195,6 +209,19 @@ public:
         return ResultStatus::ErrorNotImplemented;
     }
 
+    /**
+     * Checks the content of the application against its hashes. May run on another thread
+     * once the application is loaded.
+     * @param result Reference to add the outcome of the check to
+     * @param stop Stops the check early when set
+     * @param max_threads Number of threads doing the check, including the calling one
+     * @return ResultStatus result of function
+     */
+    virtual ResultStatus VerifyContent(VerificationResult& result, const std::atomic<bool>& stop,
+                                       std::size_t max_threads) {
+        return ResultStatus::ErrorNotImplemented;
+    }
+
 protected:
     FileUtil::IOFile file;
     bool is_loaded = false;
@@ -258,4 +258,17 @@ ResultStatus AppLoader_NCCH::ReadTitle(std::string& title) {
     return ResultStatus::Success;
 }
 
+ResultStatus AppLoader_NCCH::VerifyContent(VerificationResult& result,
+                                           const std::atomic<bool>& stop,
+                                           std::size_t max_threads) {
+    ResultStatus status = base_ncch.VerifyIntegrity(result, stop, max_threads);
+    if (status != ResultStatus::Success)
+        return status;
+
+    // The update is only checked when it is in use
+    if (overlay_ncch == &update_ncch && !stop)
+        return update_ncch.VerifyIntegrity(result, stop, max_threads);
+    return ResultStatus::Success;
+}
+
 } // namespace Loader
@@ -59,6 +59,9 @@ public:
 
     ResultStatus ReadTitle(std::string& title) override;
 
+    ResultStatus VerifyContent(VerificationResult& result, const std::atomic<bool>& stop,
+                               std::size_t max_threads) override;
+
 private:
     /**
      * Loads .code section into memory for booting
@@ -2,8 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <utility>
 #include "audio_core/dsp_interface.h"
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -11,6 +13,7 @@
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
+#include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/lock.h"
@@ -22,10 +25,11 @@ namespace Memory {
 
 class RasterizerCacheMarker {
 public:
-    void Mark(VAddr addr, bool cached) {
+    /// Marks num_pages pages starting at addr, which must all lie in the same region
+    void Mark(VAddr addr, u32 num_pages, bool cached) {
         bool* p = At(addr);
         if (p)
-            *p = cached;
+            std::fill_n(p, num_pages, cached);
     }
 
     bool IsCached(VAddr addr) {
@@ -68,9 +72,40 @@ public:
 
     ARM_Interface* cpu = nullptr;
     AudioCore::DspInterface* dsp = nullptr;
+
+    /// Whether a host pointer is in FCRAM or VRAM, the memory covered by write tracking
+    bool IsFCRAMOrVRAM(const u8* pointer) const {
+        return (pointer >= fcram.get() && pointer < fcram.get() + FCRAM_N3DS_SIZE) ||
+               (pointer >= vram.get() && pointer < vram.get() + VRAM_SIZE);
+    }
+
+    bool write_tracking = false;
+    /// One bit for each page of the physical page table, set when the page is written
+    std::vector<u64> dirty_pages;
+    /// Pages whose protection was lifted by a write, to protect again on the next collection
+    std::vector<std::pair<PageTable*, u32>> unprotected_pages;
+
+    /// Reports an access to a watched page to the GDB stub if it hits a watchpoint
+    void CheckWatchpoint(VAddr vaddr, u32 size, GDBStub::BreakpointType type) {
+        if (current_page_table->watched_pages.count(vaddr >> PAGE_BITS) == 0)
+            return;
+        if (!GDBStub::CheckWatchpoint(vaddr, size, type))
+            return;
+
+        LOG_DEBUG(HW_Memory, "Hit watchpoint @ {:08X}", vaddr);
+        GDBStub::Break(true);
+        if (cpu != nullptr)
+            cpu->PrepareReschedule();
+    }
 };
 
-MemorySystem::MemorySystem() : impl(std::make_unique<Impl>()) {}
+MemorySystem::MemorySystem()
+    : impl(std::make_unique<Impl>()),
+      physical_page_table(std::make_unique<u8*[]>(PHYSICAL_PAGE_TABLE_SIZE >> PAGE_BITS)) {
+    MapPhysicalPages(VRAM_PADDR, VRAM_SIZE, impl->vram.get());
+    MapPhysicalPages(FCRAM_PADDR, FCRAM_N3DS_SIZE, impl->fcram.get());
+    MapPhysicalPages(N3DS_EXTRA_RAM_PADDR, N3DS_EXTRA_RAM_SIZE, impl->n3ds_extra_ram.get());
+}
 MemorySystem::~MemorySystem() = default;
 
 void MemorySystem::SetCPU(ARM_Interface& cpu) {
@@ -99,6 +134,10 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, u8* memor
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
 
+        if (page_table.attributes[base] == PageType::WriteTrackedMemory ||
+            page_table.attributes[base] == PageType::WatchedMemory)
+            page_table.tracked_pointers.erase(base);
+
         page_table.attributes[base] = type;
         page_table.pointers[base] = memory;
 
@@ -106,6 +145,10 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, u8* memor
         if (type == PageType::Memory && impl->cache_marker.IsCached(base * PAGE_SIZE)) {
             page_table.attributes[base] = PageType::RasterizerCachedMemory;
             page_table.pointers[base] = nullptr;
+        } else {
+            WatchPage(page_table, base);
+            if (impl->write_tracking)
+                ProtectPage(page_table, base);
         }
 
         base += 1;
@@ -155,6 +198,166 @@ void MemorySystem::RegisterPageTable(PageTable* page_table) {
 void MemorySystem::UnregisterPageTable(PageTable* page_table) {
     impl->page_table_list.erase(
         std::find(impl->page_table_list.begin(), impl->page_table_list.end(), page_table));
+    impl->unprotected_pages.erase(
+        std::remove_if(impl->unprotected_pages.begin(), impl->unprotected_pages.end(),
+                       [page_table](const auto& entry) { return entry.first == page_table; }),
+        impl->unprotected_pages.end());
+}
+
+void MemorySystem::ProtectPage(PageTable& page_table, u32 page) {
+    u8* const pointer = page_table.pointers[page];
+    if (page_table.attributes[page] != PageType::Memory)
+        return;
+    if (!impl->IsFCRAMOrVRAM(pointer))
+        return;
+
+    page_table.attributes[page] = PageType::WriteTrackedMemory;
+    page_table.pointers[page] = nullptr;
+    page_table.tracked_pointers[page] = pointer;
+}
+
+u8* MemorySystem::UnprotectPage(const PageTable& page_table, u32 page) {
+    // Only the memory system changes page types, the page table is only const for the callers
+    const auto iter =
+        std::find(impl->page_table_list.begin(), impl->page_table_list.end(), &page_table);
+    ASSERT(iter != impl->page_table_list.end());
+    PageTable& mutable_page_table = **iter;
+
+    const auto node = mutable_page_table.tracked_pointers.extract(page);
+    ASSERT(!node.empty());
+    u8* const pointer = node.mapped();
+    mutable_page_table.attributes[page] = PageType::Memory;
+    mutable_page_table.pointers[page] = pointer;
+
+    MarkDirty(pointer, PAGE_SIZE);
+    impl->unprotected_pages.emplace_back(&mutable_page_table, page);
+    return pointer;
+}
+
+void MemorySystem::MarkDirty(const u8* pointer, std::size_t size) {
+    if (!impl->write_tracking || size == 0)
+        return;
+
+    PAddr paddr;
+    std::size_t available;
+    if (pointer >= impl->fcram.get() && pointer < impl->fcram.get() + FCRAM_N3DS_SIZE) {
+        const u32 offset = static_cast<u32>(pointer - impl->fcram.get());
+        paddr = FCRAM_PADDR + offset;
+        available = FCRAM_N3DS_SIZE - offset;
+    } else if (pointer >= impl->vram.get() && pointer < impl->vram.get() + VRAM_SIZE) {
+        const u32 offset = static_cast<u32>(pointer - impl->vram.get());
+        paddr = VRAM_PADDR + offset;
+        available = VRAM_SIZE - offset;
+    } else {
+        return;
+    }
+    // Regions running past the end of the memory area don't touch the following pages
+    size = std::min(size, available);
+
+    const u32 first_page = (paddr - PHYSICAL_PAGE_TABLE_BASE) >> PAGE_BITS;
+    const u32 last_page = (paddr + static_cast<u32>(size) - 1 - PHYSICAL_PAGE_TABLE_BASE) >>
+                          PAGE_BITS;
+    for (u32 page = first_page; page <= last_page; ++page) {
+        impl->dirty_pages[page / 64] |= u64{1} << (page % 64);
+    }
+}
+
+void MemorySystem::SetWriteTracking(bool enabled) {
+    if (impl->write_tracking == enabled)
+        return;
+    impl->write_tracking = enabled;
+    impl->unprotected_pages.clear();
+
+    if (enabled) {
+        impl->dirty_pages.assign((PHYSICAL_PAGE_TABLE_SIZE >> PAGE_BITS) / 64, 0);
+        for (PageTable* page_table : impl->page_table_list) {
+            for (u32 page = 0; page < PAGE_TABLE_NUM_ENTRIES; ++page) {
+                ProtectPage(*page_table, page);
+            }
+        }
+    } else {
+        impl->dirty_pages.clear();
+        for (PageTable* page_table : impl->page_table_list) {
+            auto& tracked_pointers = page_table->tracked_pointers;
+            for (auto iter = tracked_pointers.begin(); iter != tracked_pointers.end();) {
+                const auto [page, pointer] = *iter;
+                if (page_table->attributes[page] != PageType::WriteTrackedMemory) {
+                    ++iter;
+                    continue;
+                }
+                page_table->attributes[page] = PageType::Memory;
+                page_table->pointers[page] = pointer;
+                iter = tracked_pointers.erase(iter);
+            }
+        }
+    }
+}
+
+void MemorySystem::MarkRegionDirty(PAddr start, u32 size) {
+    MarkDirty(GetPhysicalPointer(start), size);
+}
+
+std::vector<PAddr> MemorySystem::CollectDirtyPages() {
+    std::vector<PAddr> dirty_pages;
+    for (std::size_t word = 0; word < impl->dirty_pages.size(); ++word) {
+        u64 bits = std::exchange(impl->dirty_pages[word], 0);
+        for (u32 bit = 0; bits != 0; ++bit, bits >>= 1) {
+            if (bits & 1) {
+                const u32 page = static_cast<u32>(word * 64 + bit);
+                dirty_pages.push_back(PHYSICAL_PAGE_TABLE_BASE + (page << PAGE_BITS));
+            }
+        }
+    }
+
+    for (const auto& [page_table, page] : impl->unprotected_pages) {
+        ProtectPage(*page_table, page);
+    }
+    impl->unprotected_pages.clear();
+    return dirty_pages;
+}
+
+void MemorySystem::WatchPage(PageTable& page_table, u32 page) {
+    if (page_table.watched_pages.count(page) == 0)
+        return;
+
+    switch (page_table.attributes[page]) {
+    case PageType::Memory:
+        page_table.tracked_pointers[page] = page_table.pointers[page];
+        page_table.pointers[page] = nullptr;
+        page_table.attributes[page] = PageType::WatchedMemory;
+        break;
+    case PageType::WriteTrackedMemory:
+        // Writes to watched pages mark them dirty, so the protection isn't needed anymore
+        page_table.attributes[page] = PageType::WatchedMemory;
+        break;
+    default:
+        // Other pages already take the slow path
+        break;
+    }
+}
+
+void MemorySystem::SetPagesWatched(PageTable& page_table, VAddr vaddr, u32 size, bool watched) {
+    if (size == 0)
+        return;
+
+    const u32 first_page = vaddr >> PAGE_BITS;
+    const u32 last_page = (vaddr + size - 1) >> PAGE_BITS;
+    for (u32 page = first_page; page <= last_page; ++page) {
+        if (watched) {
+            page_table.watched_pages.insert(page);
+            WatchPage(page_table, page);
+            continue;
+        }
+
+        page_table.watched_pages.erase(page);
+        if (page_table.attributes[page] == PageType::WatchedMemory) {
+            const auto node = page_table.tracked_pointers.extract(page);
+            page_table.attributes[page] = PageType::Memory;
+            page_table.pointers[page] = node.mapped();
+            if (impl->write_tracking)
+                ProtectPage(page_table, page);
+        }
+    }
 }
 
 /**
@@ -192,6 +395,7 @@ T MemorySystem::Read(const VAddr vaddr) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
+        impl->CheckWatchpoint(vaddr, sizeof(T), GDBStub::BreakpointType::Read);
         RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Flush);
 
         T value;
@@ -199,7 +403,17 @@ T MemorySystem::Read(const VAddr vaddr) {
         return value;
     }
     case PageType::Special:
+        impl->CheckWatchpoint(vaddr, sizeof(T), GDBStub::BreakpointType::Read);
         return ReadMMIO<T>(GetMMIOHandler(*impl->current_page_table, vaddr), vaddr);
+    case PageType::WatchedMemory:
+        impl->CheckWatchpoint(vaddr, sizeof(T), GDBStub::BreakpointType::Read);
+        [[fallthrough]];
+    case PageType::WriteTrackedMemory: {
+        const u8* pointer = impl->current_page_table->tracked_pointers.at(vaddr >> PAGE_BITS);
+        T value;
+        std::memcpy(&value, &pointer[vaddr & PAGE_MASK], sizeof(T));
+        return value;
+    }
     default:
         UNREACHABLE();
     }
@@ -227,13 +441,28 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
+        impl->CheckWatchpoint(vaddr, sizeof(T), GDBStub::BreakpointType::Write);
         RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
         std::memcpy(GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
+        MarkDirty(GetPointerForRasterizerCache(vaddr), sizeof(T));
         break;
     }
     case PageType::Special:
+        impl->CheckWatchpoint(vaddr, sizeof(T), GDBStub::BreakpointType::Write);
         WriteMMIO<T>(GetMMIOHandler(*impl->current_page_table, vaddr), vaddr, data);
         break;
+    case PageType::WriteTrackedMemory: {
+        u8* pointer = UnprotectPage(*impl->current_page_table, vaddr >> PAGE_BITS);
+        std::memcpy(&pointer[vaddr & PAGE_MASK], &data, sizeof(T));
+        break;
+    }
+    case PageType::WatchedMemory: {
+        impl->CheckWatchpoint(vaddr, sizeof(T), GDBStub::BreakpointType::Write);
+        u8* pointer = impl->current_page_table->tracked_pointers.at(vaddr >> PAGE_BITS);
+        std::memcpy(&pointer[vaddr & PAGE_MASK], &data, sizeof(T));
+        MarkDirty(&pointer[vaddr & PAGE_MASK], sizeof(T));
+        break;
+    }
     default:
         UNREACHABLE();
     }
@@ -246,7 +475,9 @@ bool IsValidVirtualAddress(const Kernel::Process& process, const VAddr vaddr) {
     if (page_pointer)
         return true;
 
-    if (page_table.attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory)
+    if (page_table.attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory ||
+        page_table.attributes[vaddr >> PAGE_BITS] == PageType::WriteTrackedMemory ||
+        page_table.attributes[vaddr >> PAGE_BITS] == PageType::WatchedMemory)
         return true;
 
     if (page_table.attributes[vaddr >> PAGE_BITS] != PageType::Special)
@@ -275,10 +506,42 @@ u8* MemorySystem::GetPointer(const VAddr vaddr) {
         return GetPointerForRasterizerCache(vaddr);
     }
 
+    // The caller may write through the pointer
+    if (impl->current_page_table->attributes[vaddr >> PAGE_BITS] ==
+        PageType::WriteTrackedMemory) {
+        return UnprotectPage(*impl->current_page_table, vaddr >> PAGE_BITS) + (vaddr & PAGE_MASK);
+    }
+    if (impl->current_page_table->attributes[vaddr >> PAGE_BITS] == PageType::WatchedMemory) {
+        u8* pointer = impl->current_page_table->tracked_pointers.at(vaddr >> PAGE_BITS);
+        MarkDirty(pointer, PAGE_SIZE);
+        return pointer + (vaddr & PAGE_MASK);
+    }
+
     LOG_ERROR(HW_Memory, "unknown GetPointer @ 0x{:08x}", vaddr);
     return nullptr;
 }
 
+const u8* MemorySystem::GetReadPointer(const VAddr vaddr) {
+    const u8* page_pointer = impl->current_page_table->pointers[vaddr >> PAGE_BITS];
+    if (page_pointer) {
+        return page_pointer + (vaddr & PAGE_MASK);
+    }
+
+    switch (impl->current_page_table->attributes[vaddr >> PAGE_BITS]) {
+    case PageType::RasterizerCachedMemory:
+        return GetPointerForRasterizerCache(vaddr);
+    case PageType::WriteTrackedMemory:
+    case PageType::WatchedMemory:
+        return impl->current_page_table->tracked_pointers.at(vaddr >> PAGE_BITS) +
+               (vaddr & PAGE_MASK);
+    default:
+        break;
+    }
+
+    LOG_ERROR(HW_Memory, "unknown GetReadPointer @ 0x{:08x}", vaddr);
+    return nullptr;
+}
+
 std::string MemorySystem::ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -293,7 +556,16 @@ std::string MemorySystem::ReadCString(VAddr vaddr, std::size_t max_length) {
     return string;
 }
 
-u8* MemorySystem::GetPhysicalPointer(PAddr address) {
+void MemorySystem::MapPhysicalPages(PAddr paddr, u32 size, u8* memory) {
+    ASSERT(paddr >= PHYSICAL_PAGE_TABLE_BASE &&
+           paddr - PHYSICAL_PAGE_TABLE_BASE + size <= PHYSICAL_PAGE_TABLE_SIZE);
+    const u32 first_page = (paddr - PHYSICAL_PAGE_TABLE_BASE) >> PAGE_BITS;
+    for (u32 page = 0; page < (size >> PAGE_BITS); ++page) {
+        physical_page_table[first_page + page] = memory + page * PAGE_SIZE;
+    }
+}
+
+u8* MemorySystem::GetPhysicalPointerSlow(PAddr address) {
     struct MemoryArea {
         PAddr paddr_base;
         u32 size;
@@ -341,23 +613,41 @@ u8* MemorySystem::GetPhysicalPointer(PAddr address) {
     return target_pointer;
 }
 
-/// For a rasterizer-accessible PAddr, gets a list of all possible VAddr
-static std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr) {
-    if (addr >= VRAM_PADDR && addr < VRAM_PADDR_END) {
-        return {addr - VRAM_PADDR + VRAM_VADDR};
-    }
-    if (addr >= FCRAM_PADDR && addr < FCRAM_PADDR_END) {
-        return {addr - FCRAM_PADDR + LINEAR_HEAP_VADDR, addr - FCRAM_PADDR + NEW_LINEAR_HEAP_VADDR};
-    }
-    if (addr >= FCRAM_PADDR_END && addr < FCRAM_N3DS_PADDR_END) {
-        return {addr - FCRAM_PADDR + NEW_LINEAR_HEAP_VADDR};
+/**
+ * Calls func(vaddr, num_pages) for each virtual span the physical pages [paddr, paddr_end) are
+ * visible through to the rasterizer, without allocating. Each span lies in a single region.
+ */
+template <typename Func>
+static void ForEachRasterizerVirtualSpan(PAddr paddr, PAddr paddr_end, Func&& func) {
+    struct Mapping {
+        PAddr paddr;
+        PAddr paddr_end;
+        VAddr vaddr;
+    };
+    static constexpr Mapping mappings[] = {
+        {VRAM_PADDR, VRAM_PADDR_END, VRAM_VADDR},
+        {FCRAM_PADDR, FCRAM_PADDR_END, LINEAR_HEAP_VADDR},
+        {FCRAM_PADDR, FCRAM_N3DS_PADDR_END, NEW_LINEAR_HEAP_VADDR},
+    };
+
+    for (const Mapping& mapping : mappings) {
+        const PAddr span_start = std::max(paddr, mapping.paddr);
+        const PAddr span_end = std::min(paddr_end, mapping.paddr_end);
+        if (span_start < span_end) {
+            func(span_start - mapping.paddr + mapping.vaddr, (span_end - span_start) >> PAGE_BITS);
+        }
     }
+
     // While the physical <-> virtual mapping is 1:1 for the regions supported by the cache,
     // some games (like Pokemon Super Mystery Dungeon) will try to use textures that go beyond
     // the end address of VRAM, causing the Virtual->Physical translation to fail when flushing
     // parts of the texture.
-    LOG_ERROR(HW_Memory, "Trying to use invalid physical address for rasterizer: {:08X}", addr);
-    return {};
+    const bool in_vram = paddr >= VRAM_PADDR && paddr_end <= VRAM_PADDR_END;
+    const bool in_fcram = paddr >= FCRAM_PADDR && paddr_end <= FCRAM_N3DS_PADDR_END;
+    if (!in_vram && !in_fcram) {
+        LOG_ERROR(HW_Memory, "Trying to use invalid physical address for rasterizer: {:08X}-{:08X}",
+                  paddr, paddr_end);
+    }
 }
 
 void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
@@ -365,49 +655,54 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
         return;
     }
 
-    u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
-    PAddr paddr = start;
-
-    for (unsigned i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
-        for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
-            impl->cache_marker.Mark(vaddr, cached);
-            for (PageTable* page_table : impl->page_table_list) {
-                PageType& page_type = page_table->attributes[vaddr >> PAGE_BITS];
-
-                if (cached) {
-                    // Switch page type to cached if now cached
-                    switch (page_type) {
-                    case PageType::Unmapped:
-                        // It is not necessary for a process to have this region mapped into its
-                        // address space, for example, a system module need not have a VRAM mapping.
-                        break;
-                    case PageType::Memory:
-                        page_type = PageType::RasterizerCachedMemory;
-                        page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
-                        break;
-                    default:
-                        UNREACHABLE();
-                    }
-                } else {
-                    // Switch page type to uncached if now uncached
-                    switch (page_type) {
-                    case PageType::Unmapped:
-                        // It is not necessary for a process to have this region mapped into its
-                        // address space, for example, a system module need not have a VRAM mapping.
-                        break;
-                    case PageType::RasterizerCachedMemory: {
-                        page_type = PageType::Memory;
-                        page_table->pointers[vaddr >> PAGE_BITS] =
-                            GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
-                        break;
-                    }
-                    default:
-                        UNREACHABLE();
+    const PAddr paddr = start & ~PAGE_MASK;
+    const PAddr paddr_end = ((start + size - 1) & ~PAGE_MASK) + PAGE_SIZE;
+
+    ForEachRasterizerVirtualSpan(paddr, paddr_end, [&](VAddr vaddr, u32 num_pages) {
+        impl->cache_marker.Mark(vaddr, num_pages, cached);
+
+        const u32 first = vaddr >> PAGE_BITS;
+        const u32 last = first + num_pages;
+        // Only used when uncaching, the span is backed by a single contiguous allocation
+        u8* const backing = cached ? nullptr : GetPointerForRasterizerCache(vaddr);
+
+        for (PageTable* page_table : impl->page_table_list) {
+            PageType* const attributes = page_table->attributes.data();
+            u8** const pointers = page_table->pointers.data();
+
+            // It is not necessary for a process to have the whole region mapped into its address
+            // space, for example, a system module need not have a VRAM mapping. Unmapped pages are
+            // left untouched.
+            if (cached) {
+                // Switch page type to cached if now cached
+                for (u32 page = first; page < last; ++page) {
+                    if (attributes[page] == PageType::Unmapped)
+                        continue;
+                    if (attributes[page] == PageType::WriteTrackedMemory ||
+                        attributes[page] == PageType::WatchedMemory) {
+                        // Accesses to cached pages are always seen by the memory system
+                        page_table->tracked_pointers.erase(page);
+                    } else {
+                        ASSERT(attributes[page] == PageType::Memory);
                     }
+                    attributes[page] = PageType::RasterizerCachedMemory;
+                    pointers[page] = nullptr;
+                }
+            } else {
+                // Switch page type to uncached if now uncached
+                for (u32 page = first; page < last; ++page) {
+                    if (attributes[page] == PageType::Unmapped)
+                        continue;
+                    ASSERT(attributes[page] == PageType::RasterizerCachedMemory);
+                    attributes[page] = PageType::Memory;
+                    pointers[page] = backing + ((page - first) << PAGE_BITS);
+                    WatchPage(*page_table, page);
+                    if (impl->write_tracking)
+                        ProtectPage(*page_table, page);
                 }
             }
         }
-    }
+    });
 }
 
 void RasterizerFlushRegion(PAddr start, u32 size) {
@@ -491,6 +786,27 @@ u64 MemorySystem::Read64(const VAddr addr) {
     return Read<u64_le>(addr);
 }
 
+/**
+ * Returns how many bytes of a block access starting at page_offset within page_index can be
+ * handled at once: up to the end of the page, or further if the page and the following ones are
+ * Memory pages backed by contiguous host memory.
+ */
+static std::size_t GetBlockCopyAmount(const PageTable& page_table, std::size_t page_index,
+                                      std::size_t page_offset, std::size_t remaining_size) {
+    std::size_t amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+    if (page_table.attributes[page_index] != PageType::Memory)
+        return amount;
+
+    const u8* next_pointer = page_table.pointers[page_index] + PAGE_SIZE;
+    while (amount < remaining_size && ++page_index < PAGE_TABLE_NUM_ENTRIES &&
+           page_table.attributes[page_index] == PageType::Memory &&
+           page_table.pointers[page_index] == next_pointer) {
+        amount += std::min<std::size_t>(PAGE_SIZE, remaining_size - amount);
+        next_pointer += PAGE_SIZE;
+    }
+    return amount;
+}
+
 void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_addr,
                              void* dest_buffer, const std::size_t size) {
     auto& page_table = process.vm_manager.page_table;
@@ -500,7 +816,8 @@ void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_add
     std::size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        const std::size_t copy_amount =
+            GetBlockCopyAmount(page_table, page_index, page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
         switch (page_table.attributes[page_index]) {
@@ -530,11 +847,17 @@ void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_add
             std::memcpy(dest_buffer, GetPointerForRasterizerCache(current_vaddr), copy_amount);
             break;
         }
+        case PageType::WriteTrackedMemory:
+        case PageType::WatchedMemory: {
+            const u8* src_ptr = page_table.tracked_pointers.at(page_index) + page_offset;
+            std::memcpy(dest_buffer, src_ptr, copy_amount);
+            break;
+        }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
         page_offset = 0;
         dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
         remaining_size -= copy_amount;
@@ -565,7 +888,8 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
     std::size_t page_offset = dest_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        const std::size_t copy_amount =
+            GetBlockCopyAmount(page_table, page_index, page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
         switch (page_table.attributes[page_index]) {
@@ -592,19 +916,116 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
             RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
                                          FlushMode::Invalidate);
             std::memcpy(GetPointerForRasterizerCache(current_vaddr), src_buffer, copy_amount);
+            MarkDirty(GetPointerForRasterizerCache(current_vaddr), copy_amount);
+            break;
+        }
+        case PageType::WriteTrackedMemory: {
+            u8* dest_ptr = UnprotectPage(page_table, static_cast<u32>(page_index)) + page_offset;
+            std::memcpy(dest_ptr, src_buffer, copy_amount);
+            break;
+        }
+        case PageType::WatchedMemory: {
+            u8* dest_ptr = page_table.tracked_pointers.at(page_index) + page_offset;
+            std::memcpy(dest_ptr, src_buffer, copy_amount);
+            MarkDirty(dest_ptr, copy_amount);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
         page_offset = 0;
         src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
 }
 
+bool MemorySystem::GetHostSpans(const Kernel::Process& process, const VAddr addr,
+                                const std::size_t size, const bool write, ScatterList& spans) {
+    auto& page_table = process.vm_manager.page_table;
+    std::size_t remaining_size = size;
+    std::size_t page_index = addr >> PAGE_BITS;
+    std::size_t page_offset = addr & PAGE_MASK;
+
+    spans.clear();
+    while (remaining_size > 0) {
+        const std::size_t span_size =
+            GetBlockCopyAmount(page_table, page_index, page_offset, remaining_size);
+        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+
+        u8* pointer = nullptr;
+        switch (page_table.attributes[page_index]) {
+        case PageType::Unmapped:
+        case PageType::Special:
+            return false;
+        case PageType::Memory:
+            DEBUG_ASSERT(page_table.pointers[page_index]);
+            pointer = page_table.pointers[page_index] + page_offset;
+            break;
+        case PageType::RasterizerCachedMemory:
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span_size),
+                                         write ? FlushMode::Invalidate : FlushMode::Flush);
+            pointer = GetPointerForRasterizerCache(current_vaddr);
+            break;
+        case PageType::WriteTrackedMemory:
+            pointer = write ? UnprotectPage(page_table, static_cast<u32>(page_index))
+                            : page_table.tracked_pointers.at(page_index);
+            pointer += page_offset;
+            break;
+        case PageType::WatchedMemory:
+            pointer = page_table.tracked_pointers.at(page_index) + page_offset;
+            break;
+        default:
+            UNREACHABLE();
+        }
+
+        if (!spans.empty() && spans.back().data + spans.back().size == pointer) {
+            spans.back().size += span_size;
+        } else {
+            spans.push_back({pointer, span_size});
+        }
+
+        page_index += (page_offset + span_size) >> PAGE_BITS;
+        page_offset = 0;
+        remaining_size -= span_size;
+    }
+    return true;
+}
+
+void MemorySystem::HostSpansWritten(const Kernel::Process& process, const VAddr addr,
+                                    const std::size_t size) {
+    auto& page_table = process.vm_manager.page_table;
+    std::size_t remaining_size = size;
+    std::size_t page_index = addr >> PAGE_BITS;
+    std::size_t page_offset = addr & PAGE_MASK;
+
+    while (remaining_size > 0) {
+        const std::size_t span_size =
+            GetBlockCopyAmount(page_table, page_index, page_offset, remaining_size);
+        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+
+        switch (page_table.attributes[page_index]) {
+        case PageType::RasterizerCachedMemory:
+            // Surfaces may have been loaded from the buffer while it was being written
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(span_size),
+                                         FlushMode::Invalidate);
+            MarkDirty(GetPointerForRasterizerCache(current_vaddr), span_size);
+            break;
+        case PageType::WatchedMemory:
+            MarkDirty(page_table.tracked_pointers.at(page_index) + page_offset, span_size);
+            break;
+        default:
+            // Unprotecting a write tracked page already recorded the write
+            break;
+        }
+
+        page_index += (page_offset + span_size) >> PAGE_BITS;
+        page_offset = 0;
+        remaining_size -= span_size;
+    }
+}
+
 void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_addr,
                              const std::size_t size) {
     auto& page_table = process.vm_manager.page_table;
@@ -615,7 +1036,8 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
     static const std::array<u8, PAGE_SIZE> zeros = {};
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        const std::size_t copy_amount =
+            GetBlockCopyAmount(page_table, page_index, page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
         switch (page_table.attributes[page_index]) {
@@ -642,13 +1064,25 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
             RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
                                          FlushMode::Invalidate);
             std::memset(GetPointerForRasterizerCache(current_vaddr), 0, copy_amount);
+            MarkDirty(GetPointerForRasterizerCache(current_vaddr), copy_amount);
+            break;
+        }
+        case PageType::WriteTrackedMemory: {
+            u8* dest_ptr = UnprotectPage(page_table, static_cast<u32>(page_index)) + page_offset;
+            std::memset(dest_ptr, 0, copy_amount);
+            break;
+        }
+        case PageType::WatchedMemory: {
+            u8* dest_ptr = page_table.tracked_pointers.at(page_index) + page_offset;
+            std::memset(dest_ptr, 0, copy_amount);
+            MarkDirty(dest_ptr, copy_amount);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
         page_offset = 0;
         remaining_size -= copy_amount;
     }
@@ -662,7 +1096,8 @@ void MemorySystem::CopyBlock(const Kernel::Process& process, VAddr dest_addr, VA
     std::size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        const std::size_t copy_amount =
+            GetBlockCopyAmount(page_table, page_index, page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
         switch (page_table.attributes[page_index]) {
@@ -694,11 +1129,17 @@ void MemorySystem::CopyBlock(const Kernel::Process& process, VAddr dest_addr, VA
                        copy_amount);
             break;
         }
+        case PageType::WriteTrackedMemory:
+        case PageType::WatchedMemory: {
+            const u8* src_ptr = page_table.tracked_pointers.at(page_index) + page_offset;
+            WriteBlock(process, dest_addr, src_ptr, copy_amount);
+            break;
+        }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
         page_offset = 0;
         dest_addr += static_cast<VAddr>(copy_amount);
         src_addr += static_cast<VAddr>(copy_amount);
@@ -715,7 +1156,8 @@ void MemorySystem::CopyBlock(const Kernel::Process& src_process,
     std::size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        const std::size_t copy_amount =
+            GetBlockCopyAmount(page_table, page_index, page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
         switch (page_table.attributes[page_index]) {
@@ -747,11 +1189,17 @@ void MemorySystem::CopyBlock(const Kernel::Process& src_process,
                        copy_amount);
             break;
         }
+        case PageType::WriteTrackedMemory:
+        case PageType::WatchedMemory: {
+            const u8* src_ptr = page_table.tracked_pointers.at(page_index) + page_offset;
+            WriteBlock(dest_process, dest_addr, src_ptr, copy_amount);
+            break;
+        }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
         page_offset = 0;
         dest_addr += static_cast<VAddr>(copy_amount);
         src_addr += static_cast<VAddr>(copy_amount);
@@ -811,6 +1259,7 @@ u8* MemorySystem::GetFCRAMPointer(u32 offset) {
 
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
+    MapPhysicalPages(DSP_RAM_PADDR, DSP_RAM_SIZE, dsp.GetDspMemory().data());
 }
 
 } // namespace Memory
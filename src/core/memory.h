@@ -8,6 +8,8 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "common/common_types.h"
 #include "core/mmio.h"
@@ -46,6 +48,12 @@ enum class PageType {
     RasterizerCachedMemory,
     /// Page is mapped to a I/O region. Writing and reading to this page is handled by functions.
     Special,
+    /// Page is mapped to regular memory whose writes are being tracked. Accesses go through the
+    /// slow path until the page is written, which marks it dirty and turns it back into `Memory`.
+    WriteTrackedMemory,
+    /// Page is mapped to regular memory holding a GDB stub watchpoint. Accesses go through the
+    /// slow path, which checks them against the watchpoints.
+    WatchedMemory,
 };
 
 struct SpecialRegion {
@@ -73,6 +81,15 @@ struct PageTable {
      */
     std::vector<SpecialRegion> special_regions;
 
+    /**
+     * Memory backing the pages whose entries in the `attributes` array are of type
+     * `WriteTrackedMemory` or `WatchedMemory`, as their entries in `pointers` are null.
+     */
+    std::unordered_map<u32, u8*> tracked_pointers;
+
+    /// Pages holding a GDB stub watchpoint. Those mapped to regular memory are `WatchedMemory`.
+    std::unordered_set<u32> watched_pages;
+
     /**
      * Array of fine grained page attributes. If it is set to any value other than `Memory`, then
      * the corresponding entry in `pointers` MUST be set to null.
@@ -185,6 +202,15 @@ enum : VAddr {
     NEW_LINEAR_HEAP_VADDR_END = NEW_LINEAR_HEAP_VADDR + NEW_LINEAR_HEAP_SIZE,
 };
 
+/// Range of host memory backing part of a guest buffer
+struct HostSpan {
+    u8* data;
+    std::size_t size;
+};
+
+/// Host memory backing a guest buffer, in order
+using ScatterList = std::vector<HostSpan>;
+
 /**
  * Flushes any externally cached rasterizer resources touching the given region.
  */
@@ -268,15 +294,50 @@ public:
     void CopyBlock(const Kernel::Process& src_process, const Kernel::Process& dest_process,
                    VAddr src_addr, VAddr dest_addr, std::size_t size);
 
+    /**
+     * Resolves a guest buffer to the host memory backing it, so that it can be accessed in place
+     * instead of through ReadBlock or WriteBlock. Cached surfaces overlapping the buffer are
+     * flushed, or invalidated if it is going to be written.
+     * @param write Whether the host memory is going to be written, in which case HostSpansWritten
+     * must be called once the writes are done
+     * @returns false if part of the buffer is not backed by memory (unmapped or MMIO pages)
+     */
+    bool GetHostSpans(const Kernel::Process& process, VAddr addr, std::size_t size, bool write,
+                      ScatterList& spans);
+
+    /**
+     * Finishes writing to the host spans of a guest buffer: invalidates the cached surfaces that
+     * were loaded from it in the meantime and marks the pages as written.
+     */
+    void HostSpansWritten(const Kernel::Process& process, VAddr addr, std::size_t size);
+
     std::string ReadCString(VAddr vaddr, std::size_t max_length);
 
     /**
      * Gets a pointer to the memory region beginning at the specified physical address.
+     * Translation is a lookup in a flat table of the physical pages, so that the video core can
+     * afford it for every vertex, texel and pixel.
      */
-    u8* GetPhysicalPointer(PAddr address);
+    u8* GetPhysicalPointer(PAddr address) {
+        const PAddr offset = address - PHYSICAL_PAGE_TABLE_BASE;
+        if (offset < PHYSICAL_PAGE_TABLE_SIZE) {
+            u8* const page_pointer = physical_page_table[offset >> PAGE_BITS];
+            if (page_pointer != nullptr)
+                return page_pointer + (address & PAGE_MASK);
+        }
+        return GetPhysicalPointerSlow(address);
+    }
 
+    /**
+     * Gets a pointer to the memory at the specified virtual address for writing. A write-tracked
+     * page is marked dirty and loses its protection.
+     */
     u8* GetPointer(VAddr vaddr);
 
+    /// Gets a pointer to the memory at the specified virtual address for reading only, which
+    /// leaves write-tracked pages protected and clean
+    const u8* GetReadPointer(VAddr vaddr);
+
     bool IsValidPhysicalAddress(PAddr paddr);
 
     /// Gets offset in FCRAM from a pointer inside FCRAM range
@@ -298,6 +359,32 @@ public:
 
     void SetDSP(AudioCore::DspInterface& dsp);
 
+    /**
+     * Starts or stops tracking the CPU writes to FCRAM and VRAM. While tracking, pages are
+     * write-protected in every registered page table (including for the JIT), and the first write
+     * to a page marks it dirty and lifts the protection.
+     */
+    void SetWriteTracking(bool enabled);
+
+    /**
+     * Returns the physical address of every FCRAM and VRAM page written since tracking started or
+     * since the previous call, then clears them and write-protects them again.
+     */
+    std::vector<PAddr> CollectDirtyPages();
+
+    /**
+     * Marks the FCRAM and VRAM pages of a physical region as dirty. This is for the writes that
+     * bypass the page tables, like the GPU writing through physical pointers.
+     */
+    void MarkRegionDirty(PAddr start, u32 size);
+
+    /**
+     * Sets whether the CPU accesses to the pages of [vaddr, vaddr + size) in a page table are
+     * checked against the GDB stub watchpoints. Watched pages lose their fast path, including in
+     * the JIT, while all other pages keep it.
+     */
+    void SetPagesWatched(PageTable& page_table, VAddr vaddr, u32 size, bool watched);
+
 private:
     template <typename T>
     T Read(const VAddr vaddr);
@@ -315,9 +402,35 @@ private:
 
     void MapPages(PageTable& page_table, u32 base, u32 size, u8* memory, PageType type);
 
+    /// Handles the addresses missing from the physical page table, i.e. the end addresses of the
+    /// memory areas and invalid addresses
+    u8* GetPhysicalPointerSlow(PAddr address);
+
+    /// Adds the pages of a memory area to the physical page table
+    void MapPhysicalPages(PAddr paddr, u32 size, u8* memory);
+
+    /// Write-protects a Memory page backed by FCRAM or VRAM, other pages are left untouched
+    void ProtectPage(PageTable& page_table, u32 page);
+
+    /// Lifts the write protection of a page and marks it dirty, returning its pointer
+    u8* UnprotectPage(const PageTable& page_table, u32 page);
+
+    /// Marks the FCRAM or VRAM pages touched by a write through a host pointer as dirty
+    void MarkDirty(const u8* pointer, std::size_t size);
+
+    /// Turns a Memory or WriteTrackedMemory page into a WatchedMemory page if it is watched
+    void WatchPage(PageTable& page_table, u32 page);
+
     class Impl;
 
     std::unique_ptr<Impl> impl;
+
+    /// The physical page table spans from the start of VRAM to the end of the New 3DS FCRAM
+    static constexpr PAddr PHYSICAL_PAGE_TABLE_BASE = VRAM_PADDR;
+    static constexpr u32 PHYSICAL_PAGE_TABLE_SIZE = FCRAM_N3DS_PADDR_END - VRAM_PADDR;
+
+    /// Host pointer backing each physical page, or nullptr outside of the memory areas
+    std::unique_ptr<u8*[]> physical_page_table;
 };
 
 /// Determines if the given VAddr is valid for the specified process.
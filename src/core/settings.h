@@ -32,6 +32,20 @@ enum class MicInputType {
     Static,
 };
 
+/// When the save data written by titles is synced to the storage device
+enum class SaveDataSync {
+    Never,   ///< Left to the OS
+    OnClose, ///< When a save file is closed
+    OnFlush, ///< Whenever buffered save data is written out to the file
+};
+
+/// When the hashes of the ExeFS and RomFS of the booted title are checked
+enum class ContentVerification {
+    Off,
+    Background, ///< Alongside emulation, once the title is booted
+    BeforeBoot, ///< Before booting the title, which delays the boot
+};
+
 namespace NativeButton {
 enum Values {
     A,
@@ -129,6 +143,10 @@ struct Values {
 
     // Data Storage
     bool use_virtual_sd;
+    bool cache_decrypted_content;
+    u32 romfs_cache_size; ///< In MiB, memory used by each RomFS for its decrypted blocks
+    SaveDataSync save_data_sync;
+    ContentVerification verify_content;
 
     // System
     int region_value;
@@ -142,6 +160,8 @@ struct Values {
     bool shaders_accurate_gs;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_disk_shader_cache;
+    bool use_async_shader_compilation;
     u16 resolution_factor;
     bool vsync_enabled;
     bool use_frame_limit;
@@ -177,6 +177,10 @@ TelemetrySession::TelemetrySession() {
              Settings::values.shaders_accurate_mul);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_UseShaderJit",
              Settings::values.use_shader_jit);
+    AddField(Telemetry::FieldType::UserConfig, "Renderer_UseDiskShaderCache",
+             Settings::values.use_disk_shader_cache);
+    AddField(Telemetry::FieldType::UserConfig, "Renderer_UseAsyncShaderCompilation",
+             Settings::values.use_async_shader_compilation);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_UseVsync", Settings::values.vsync_enabled);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_Toggle3d", Settings::values.toggle_3d);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_Factor3d",
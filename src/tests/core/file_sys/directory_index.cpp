@@ -0,0 +1,55 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/directory_index.h"
+
+namespace FileSys {
+
+TEST_CASE("DirectoryIndex", "[core][file_sys]") {
+    const std::string test_dir = "./test_index";
+    FileUtil::CreateDir(test_dir);
+    FileUtil::CreateDir(test_dir + "/z");
+    FileUtil::CreateEmptyFile(test_dir + "/a");
+
+    DirectoryIndex index(test_dir + "/");
+    REQUIRE(index.GetHostStatus(test_dir + "/a") == PathParser::FileFound);
+    REQUIRE(index.GetHostStatus(test_dir + "/b") == PathParser::NotFound);
+    REQUIRE(index.GetHostStatus(test_dir + "/z") == PathParser::DirectoryFound);
+    REQUIRE(index.GetHostStatus(test_dir + "/a/c") == PathParser::FileInPath);
+    REQUIRE(index.GetHostStatus(test_dir + "/b/c") == PathParser::PathNotFound);
+    REQUIRE(index.GetHostStatus(test_dir + "/z/../a") == PathParser::FileFound);
+    REQUIRE(DirectoryIndex("./missing").GetHostStatus("./missing/a") ==
+            PathParser::InvalidMountPoint);
+
+    auto root = index.GetDirectory(test_dir);
+    REQUIRE(root != nullptr);
+    REQUIRE(root->children.size() == 2);
+    REQUIRE(index.GetDirectory(test_dir + "/b") == nullptr);
+
+    // Entries the index missed are still found on the host
+    FileUtil::CreateEmptyFile(test_dir + "/z/d");
+    REQUIRE(index.GetHostStatus(test_dir + "/z/d") == PathParser::FileFound);
+
+    // Changes reported by the archive are picked up
+    FileUtil::Delete(test_dir + "/a");
+    index.Invalidate(test_dir + "/a");
+    REQUIRE(index.GetHostStatus(test_dir + "/a") == PathParser::NotFound);
+    REQUIRE(index.GetDirectory(test_dir + "/z")->children.size() == 1);
+
+    // Listings handed out earlier are left untouched
+    REQUIRE(root->children.size() == 2);
+
+    // Changes made by other programs are picked up, through inotify or by checking the host again
+    REQUIRE(index.GetHostStatus(test_dir + "/z/d") == PathParser::FileFound);
+    FileUtil::Delete(test_dir + "/z/d");
+    REQUIRE(index.GetHostStatus(test_dir + "/z/d") == PathParser::NotFound);
+    FileUtil::CreateDir(test_dir + "/z/d");
+    REQUIRE(index.GetHostStatus(test_dir + "/z/d/e") == PathParser::NotFound);
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+} // namespace FileSys
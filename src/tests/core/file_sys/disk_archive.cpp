@@ -0,0 +1,81 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <string>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/disk_archive.h"
+
+namespace FileSys {
+
+TEST_CASE("DiskFile write-back buffering", "[file_sys]") {
+    const std::string path = "disk_file_write_back.bin";
+    Mode mode;
+    mode.read_flag.Assign(1);
+    mode.write_flag.Assign(1);
+
+    {
+        DiskFile file(FileUtil::IOFile(path, "w+b"), mode, nullptr, true);
+
+        // Small adjacent records are coalesced in memory
+        for (u8 i = 0; i < 64; ++i) {
+            const std::array<u8, 4> record{i, i, i, i};
+            REQUIRE(file.Write(i * record.size(), record.size(), false, record.data()).Unwrap() ==
+                    record.size());
+        }
+        REQUIRE(file.GetSize() == 256);
+        REQUIRE(FileUtil::GetSize(path) == 0);
+
+        // Reads see the buffered data
+        std::array<u8, 256> data{};
+        REQUIRE(file.Read(0, data.size(), data.data()).Unwrap() == data.size());
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            REQUIRE(data[i] == i / 4);
+        }
+
+        // Overwriting part of the buffer and writing past the end both land in the file
+        const std::array<u8, 2> patch{0xAA, 0xBB};
+        file.Write(10, patch.size(), false, patch.data());
+        file.Write(1024, patch.size(), false, patch.data());
+        REQUIRE(file.GetSize() == 1026);
+
+        REQUIRE(file.Flush());
+        REQUIRE(file.Read(10, patch.size(), data.data()).Unwrap() == patch.size());
+        REQUIRE(data[0] == 0xAA);
+        REQUIRE(data[1] == 0xBB);
+
+        // A write asking for a flush reaches the file before it returns
+        REQUIRE(file.Write(2048, patch.size(), true, patch.data()).Unwrap() == patch.size());
+        REQUIRE(FileUtil::GetSize(path) == 2050);
+        file.Write(4096, patch.size(), false, patch.data());
+    }
+
+    // Destroying the file closes it, which writes out the remaining data
+    REQUIRE(FileUtil::GetSize(path) == 4098);
+    FileUtil::Delete(path);
+}
+
+TEST_CASE("DiskFile write-back failure", "[file_sys]") {
+    const std::string path = "disk_file_write_back_failure.bin";
+    FileUtil::IOFile(path, "wb");
+    Mode mode;
+    mode.read_flag.Assign(1);
+    mode.write_flag.Assign(1);
+
+    // The host file is read-only, so writing out the buffer fails
+    DiskFile file(FileUtil::IOFile(path, "rb"), mode, nullptr, true);
+    const std::array<u8, 4> record{1, 2, 3, 4};
+    REQUIRE(file.Write(0, record.size(), false, record.data()).Unwrap() == record.size());
+
+    // The buffered write was reported as successful, so the failure sticks to the file
+    REQUIRE(file.Write(4, record.size(), true, record.data()).Failed());
+    REQUIRE(!file.Flush());
+    REQUIRE(file.Write(8, record.size(), false, record.data()).Failed());
+
+    file.Close();
+    FileUtil::Delete(path);
+}
+
+} // namespace FileSys
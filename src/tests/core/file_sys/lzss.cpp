@@ -0,0 +1,206 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/file_sys/lzss.h"
+
+namespace FileSys {
+
+namespace {
+
+/**
+ * Greedy compressor for the backward LZSS format. The whole input is encoded, and the tokens are
+ * laid out in the order the decompressor reads them, from the end of the encoded data.
+ */
+std::vector<u8> Compress(const std::vector<u8>& data) {
+    const u32 size = static_cast<u32>(data.size());
+    std::vector<u8> stream; // In reading order
+    std::size_t control_index = 0;
+    unsigned num_tokens = 8;
+
+    u32 out = size;
+    while (out > 0) {
+        if (num_tokens == 8) {
+            control_index = stream.size();
+            stream.push_back(0);
+            num_tokens = 0;
+        }
+
+        // The byte at out - 1 - j is copied from the one at out - 1 - j + distance
+        u32 best_size = 0;
+        u32 best_distance = 0;
+        for (u32 distance = 3; distance <= 0x1002 && out - 1 + distance < size; ++distance) {
+            u32 match_size = 0;
+            while (match_size < 18 && match_size < out &&
+                   data[out - 1 - match_size] == data[out - 1 - match_size + distance]) {
+                ++match_size;
+            }
+            if (match_size > best_size) {
+                best_size = match_size;
+                best_distance = distance;
+            }
+        }
+
+        if (best_size >= 3) {
+            const u32 info = ((best_size - 3) << 12) | (best_distance - 3);
+            stream[control_index] |= 0x80 >> num_tokens;
+            stream.push_back(static_cast<u8>(info >> 8));
+            stream.push_back(static_cast<u8>(info & 0xFF));
+            out -= best_size;
+        } else {
+            stream.push_back(data[--out]);
+        }
+        ++num_tokens;
+    }
+
+    std::vector<u8> compressed(stream.rbegin(), stream.rend());
+    const u32 compressed_size = static_cast<u32>(compressed.size()) + 8;
+    const u32 buffer_top_and_bottom = (8 << 24) | compressed_size;
+    const u32 offset_size = size - compressed_size;
+    compressed.resize(compressed_size);
+    std::memcpy(&compressed[compressed_size - 8], &buffer_top_and_bottom, sizeof(u32));
+    std::memcpy(&compressed[compressed_size - 4], &offset_size, sizeof(u32));
+    return compressed;
+}
+
+/// Byte by byte decompressor the optimized one is checked against
+bool ReferenceDecompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                         u32 decompressed_size) {
+    const u8* footer = compressed + compressed_size - 8;
+
+    u32 buffer_top_and_bottom;
+    std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
+
+    u32 out = decompressed_size;
+    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
+    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
+
+    std::memset(decompressed, 0, decompressed_size);
+    std::memcpy(decompressed, compressed, compressed_size);
+
+    while (index > stop_index) {
+        u8 control = compressed[--index];
+
+        for (unsigned i = 0; i < 8; i++) {
+            if (index <= stop_index || out <= 0)
+                break;
+
+            if (control & 0x80) {
+                if (index < 2)
+                    return false;
+                index -= 2;
+
+                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
+                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
+                segment_offset &= 0x0FFF;
+                segment_offset += 2;
+
+                if (out < segment_size)
+                    return false;
+
+                for (unsigned j = 0; j < segment_size; j++) {
+                    if (out + segment_offset >= decompressed_size)
+                        return false;
+                    u8 data = decompressed[out + segment_offset];
+                    decompressed[--out] = data;
+                }
+            } else {
+                if (out < 1)
+                    return false;
+                decompressed[--out] = compressed[--index];
+            }
+            control <<= 1;
+        }
+    }
+    return true;
+}
+
+/// Data with repeats of various lengths and periods, including overlapping ones
+std::vector<u8> MakeCompressibleData(std::mt19937& rng, std::size_t size) {
+    std::vector<u8> data;
+    while (data.size() < size) {
+        if (data.size() < 16 || rng() % 3 == 0) {
+            data.push_back(static_cast<u8>(rng()));
+            continue;
+        }
+        const std::size_t period = 1 + rng() % std::min<std::size_t>(data.size(), 64);
+        const std::size_t length = 3 + rng() % 40;
+        for (std::size_t i = 0; i < length; ++i) {
+            data.push_back(data[data.size() - period]);
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("LZSS round trip", "[core][file_sys]") {
+    std::mt19937 rng(1234);
+    for (std::size_t size : {64, 1000, 4096, 20000}) {
+        const std::vector<u8> data = MakeCompressibleData(rng, size);
+        const std::vector<u8> compressed = Compress(data);
+        REQUIRE(compressed.size() < data.size());
+
+        const u32 compressed_size = static_cast<u32>(compressed.size());
+        const u32 decompressed_size = LZSS_GetDecompressedSize(compressed.data(), compressed_size);
+        REQUIRE(decompressed_size == data.size());
+
+        std::vector<u8> decompressed(decompressed_size);
+        REQUIRE(LZSS_Decompress(compressed.data(), compressed_size, decompressed.data(),
+                                decompressed_size));
+        REQUIRE(decompressed == data);
+    }
+}
+
+TEST_CASE("LZSS matches the reference on corrupted data", "[core][file_sys]") {
+    std::mt19937 rng(5678);
+    const std::vector<u8> data = MakeCompressibleData(rng, 4096);
+    const std::vector<u8> compressed = Compress(data);
+    const u32 compressed_size = static_cast<u32>(compressed.size());
+
+    std::vector<u8> expected(data.size());
+    std::vector<u8> decompressed(data.size());
+    for (int iteration = 0; iteration < 1000; ++iteration) {
+        // Corrupt the encoded tokens, leaving the footer valid for the reference decompressor
+        std::vector<u8> corrupted = compressed;
+        const unsigned num_changes = 1 + rng() % 8;
+        for (unsigned i = 0; i < num_changes; ++i) {
+            corrupted[rng() % (compressed_size - 8)] = static_cast<u8>(rng());
+        }
+
+        const bool expected_result = ReferenceDecompress(corrupted.data(), compressed_size,
+                                                         expected.data(), expected.size());
+        const bool result = LZSS_Decompress(corrupted.data(), compressed_size,
+                                            decompressed.data(), decompressed.size());
+        REQUIRE(result == expected_result);
+        if (result)
+            REQUIRE(decompressed == expected);
+    }
+}
+
+TEST_CASE("LZSS stays within the buffers on garbage input", "[core][file_sys]") {
+    std::mt19937 rng(9012);
+    std::vector<u8> decompressed(0x1000);
+    for (int iteration = 0; iteration < 1000; ++iteration) {
+        std::vector<u8> garbage(rng() % 64);
+        for (u8& byte : garbage) {
+            byte = static_cast<u8>(rng());
+        }
+
+        const u32 size = static_cast<u32>(garbage.size());
+        const u32 decompressed_size = LZSS_GetDecompressedSize(garbage.data(), size);
+        if (decompressed_size > decompressed.size())
+            continue;
+        // Only the result matters, the decompressor must stay within the buffers
+        LZSS_Decompress(garbage.data(), size, decompressed.data(), decompressed_size);
+    }
+    REQUIRE(LZSS_GetDecompressedSize(nullptr, 4) == 0);
+}
+
+} // namespace FileSys
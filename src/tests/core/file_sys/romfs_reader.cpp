@@ -0,0 +1,49 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/romfs_reader.h"
+
+namespace FileSys {
+
+TEST_CASE("RomFSReader mapped reads", "[core][file_sys]") {
+    const std::string path = "romfs_reader_mapped.bin";
+    constexpr std::size_t romfs_offset = 0x1234;
+    constexpr std::size_t romfs_size = 3 * RomFSReader::BLOCK_SIZE + 0x56;
+
+    std::vector<u8> contents(romfs_offset + romfs_size);
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        contents[i] = static_cast<u8>(i * 7 + i / 251);
+    }
+    {
+        FileUtil::IOFile file(path, "wb");
+        REQUIRE(file.WriteBytes(contents.data(), contents.size()) == contents.size());
+    }
+
+    {
+        // The RomFS claims more data than the host file holds
+        RomFSReader reader(FileUtil::IOFile(path, "rb"), romfs_offset, romfs_size + 0x100);
+        REQUIRE(reader.GetSize() == romfs_size + 0x100);
+
+        std::vector<u8> buffer(RomFSReader::BLOCK_SIZE);
+        for (std::size_t offset = 0; offset < romfs_size; offset += 0x3000) {
+            const std::size_t length = std::min<std::size_t>(0x5000, romfs_size - offset);
+            REQUIRE(reader.ReadFile(offset, length, buffer.data()) == length);
+            REQUIRE(std::equal(buffer.begin(), buffer.begin() + length,
+                               contents.begin() + romfs_offset + offset));
+        }
+
+        REQUIRE(reader.ReadFile(romfs_size - 0x10, 0x100, buffer.data()) == 0x10);
+        REQUIRE(reader.ReadFile(romfs_size, 0x10, buffer.data()) == 0);
+        REQUIRE(reader.ReadFile(romfs_size + 0x100, 0x10, buffer.data()) == 0);
+    }
+
+    FileUtil::Delete(path);
+}
+
+} // namespace FileSys
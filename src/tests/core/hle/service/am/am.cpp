@@ -0,0 +1,175 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <cryptopp/sha.h>
+#include "common/alignment.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/file_sys/cia_common.h"
+#include "core/file_sys/cia_container.h"
+#include "core/file_sys/ticket.h"
+#include "core/file_sys/title_metadata.h"
+#include "core/hle/service/am/am.h"
+#include "core/hle/service/fs/archive.h"
+
+namespace Service::AM {
+
+namespace {
+
+constexpr u64 TEST_TITLE_ID = 0x0004000000CA1400;
+
+/// Size of a ticket or TMD signature of type Rsa2048Sha256, with the signature type before it
+constexpr std::size_t SIGNATURE_AREA_SIZE = 0x140;
+
+/// Puts the test installs in a directory of their own instead of the user directory
+std::string SetUpUserDirectory() {
+    const std::string user_dir = "am_test_user" DIR_SEP;
+    FileUtil::DeleteDirRecursively(user_dir);
+    FileUtil::SetUserPath(user_dir);
+    REQUIRE(FileUtil::GetUserPath(FileUtil::UserPath::SDMCDir) == user_dir + SDMC_DIR DIR_SEP);
+    return user_dir;
+}
+
+/// Fills the contents of a test CIA with a pattern that differs between contents
+std::vector<std::vector<u8>> MakeContents(const std::vector<std::size_t>& sizes) {
+    std::vector<std::vector<u8>> contents;
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        std::vector<u8> content(sizes[i]);
+        for (std::size_t j = 0; j < content.size(); j++)
+            content[j] = static_cast<u8>(j * 7 + j / 0x1000 + i);
+        contents.push_back(std::move(content));
+    }
+    return contents;
+}
+
+/**
+ * Writes an unencrypted CIA with the given contents, whose TMD lists the given content hashes
+ * @returns the path of the CIA
+ */
+std::string WriteCIA(const std::vector<std::vector<u8>>& contents,
+                     const std::vector<std::array<u8, 0x20>>& hashes) {
+    const std::size_t tik_size = SIGNATURE_AREA_SIZE + sizeof(FileSys::Ticket::Body);
+    const std::size_t tmd_size = SIGNATURE_AREA_SIZE + sizeof(FileSys::TitleMetadata::Body) +
+                                 contents.size() * sizeof(FileSys::TitleMetadata::ContentChunk);
+    u64 content_size = 0;
+    for (const auto& content : contents)
+        content_size += content.size();
+
+    // No certificates, so the ticket follows the header
+    const std::size_t tik_offset = Common::AlignUp(FileSys::CIA_HEADER_SIZE, 0x40);
+    const std::size_t tmd_offset = Common::AlignUp(tik_offset + tik_size, 0x40);
+    const std::size_t content_offset = Common::AlignUp(tmd_offset + tmd_size, 0x40);
+    std::vector<u8> cia(content_offset);
+
+    const auto put_u32_le = [&cia](std::size_t offset, u32 value) {
+        for (std::size_t i = 0; i < sizeof(u32); i++)
+            cia[offset + i] = static_cast<u8>(value >> (8 * i));
+    };
+    put_u32_le(0x00, static_cast<u32>(FileSys::CIA_HEADER_SIZE));
+    put_u32_le(0x0C, static_cast<u32>(tik_size));
+    put_u32_le(0x10, static_cast<u32>(tmd_size));
+    put_u32_le(0x18, static_cast<u32>(content_size));
+    put_u32_le(0x1C, static_cast<u32>(content_size >> 32));
+    for (std::size_t i = 0; i < contents.size(); i++)
+        cia[0x20 + i / 8] |= 0x80 >> (i % 8);
+
+    const u32_be signature_type = FileSys::TMDSignatureType::Rsa2048Sha256;
+    std::memcpy(&cia[tik_offset], &signature_type, sizeof(signature_type));
+    std::memcpy(&cia[tmd_offset], &signature_type, sizeof(signature_type));
+
+    FileSys::TitleMetadata::Body tmd_body{};
+    tmd_body.title_id = TEST_TITLE_ID;
+    tmd_body.content_count = static_cast<u16>(contents.size());
+    std::memcpy(&cia[tmd_offset + SIGNATURE_AREA_SIZE], &tmd_body, sizeof(tmd_body));
+    for (std::size_t i = 0; i < contents.size(); i++) {
+        FileSys::TitleMetadata::ContentChunk chunk{};
+        chunk.id = static_cast<u32>(i);
+        chunk.index = static_cast<u16>(i);
+        chunk.size = contents[i].size();
+        chunk.hash = hashes[i];
+        std::memcpy(&cia[tmd_offset + SIGNATURE_AREA_SIZE + sizeof(tmd_body) + i * sizeof(chunk)],
+                    &chunk, sizeof(chunk));
+    }
+
+    const std::string path = "am_test.cia";
+    FileUtil::IOFile file(path, "wb");
+    REQUIRE(file.WriteBytes(cia.data(), cia.size()) == cia.size());
+    for (const auto& content : contents)
+        REQUIRE(file.WriteBytes(content.data(), content.size()) == content.size());
+    return path;
+}
+
+std::array<u8, 0x20> HashContent(const std::vector<u8>& content) {
+    std::array<u8, 0x20> hash;
+    CryptoPP::SHA256().CalculateDigest(hash.data(), content.data(), content.size());
+    return hash;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("AM::InstallCIA with contents split across many chunks", "[core][am]") {
+    const std::string user_dir = SetUpUserDirectory();
+
+    // More content data than the install reads ahead of its workers, in uneven chunks
+    const auto contents = MakeContents({0x1400003, 0x100000, 0x17FFFFF, 0x11});
+    std::vector<std::array<u8, 0x20>> hashes;
+    for (const auto& content : contents)
+        hashes.push_back(HashContent(content));
+    const std::string path = WriteCIA(contents, hashes);
+
+    std::size_t last_written = 0;
+    std::size_t total = 0;
+    REQUIRE(InstallCIA(path, [&](std::size_t written, std::size_t total_size) {
+                REQUIRE(written >= last_written);
+                last_written = written;
+                total = total_size;
+            }) == InstallStatus::Success);
+    REQUIRE(last_written == total);
+
+    for (u16 i = 0; i < contents.size(); i++) {
+        FileUtil::IOFile file(GetTitleContentPath(FS::MediaType::SDMC, TEST_TITLE_ID, i), "rb");
+        std::vector<u8> installed(file.GetSize());
+        REQUIRE(file.ReadBytes(installed.data(), installed.size()) == installed.size());
+        REQUIRE(installed == contents[i]);
+    }
+
+    FileUtil::Delete(path);
+    FileUtil::DeleteDirRecursively(user_dir);
+}
+
+TEST_CASE("AM::InstallCIA with a content hash mismatch", "[core][am]") {
+    const std::string user_dir = SetUpUserDirectory();
+
+    const auto contents = MakeContents({0x200000, 0x1234});
+    std::vector<std::array<u8, 0x20>> hashes;
+    for (const auto& content : contents)
+        hashes.push_back(HashContent(content));
+    hashes[1][0] ^= 1;
+    const std::string path = WriteCIA(contents, hashes);
+
+    REQUIRE(InstallCIA(path) == InstallStatus::ErrorAborted);
+
+    FileUtil::Delete(path);
+    FileUtil::DeleteDirRecursively(user_dir);
+}
+
+TEST_CASE("AM::CIAFile contents without title metadata", "[core][am]") {
+    const std::string user_dir = SetUpUserDirectory();
+
+    const std::string path = WriteCIA(MakeContents({0x10}), std::vector<std::array<u8, 0x20>>(1));
+    FileUtil::IOFile file(path, "rb");
+    CIAFile cia_file(FS::MediaType::SDMC);
+    REQUIRE(cia_file.InstallContents(file, nullptr).IsError());
+
+    file.Close();
+    FileUtil::Delete(path);
+    FileUtil::DeleteDirRecursively(user_dir);
+}
+
+} // namespace Service::AM
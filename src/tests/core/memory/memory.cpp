@@ -2,6 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <vector>
 #include <catch2/catch.hpp>
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -54,3 +58,223 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::MemorySystem block operations", "[core][memory]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    // The two halves of the range are mapped in reverse order, so that block operations crossing
+    // between them can't be merged into a single copy
+    constexpr u32 half_size = 4 * Memory::PAGE_SIZE;
+    std::vector<u8> backing(2 * half_size);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR, backing.data() + half_size, half_size,
+                                  Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR + half_size, backing.data(), half_size,
+                                  Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+
+    auto BackingAt = [&](u32 offset) {
+        return offset < half_size ? backing[half_size + offset] : backing[offset - half_size];
+    };
+
+    constexpr u32 offset = 100;
+    std::vector<u8> data(2 * half_size - 2 * offset);
+    std::iota(data.begin(), data.end(), u8{1});
+    memory.WriteBlock(*process, Memory::HEAP_VADDR + offset, data.data(), data.size());
+    for (u32 i = 0; i < data.size(); ++i) {
+        REQUIRE(BackingAt(offset + i) == data[i]);
+    }
+    REQUIRE(BackingAt(offset - 1) == 0);
+    REQUIRE(BackingAt(offset + static_cast<u32>(data.size())) == 0);
+
+    std::vector<u8> read(data.size());
+    memory.ReadBlock(*process, Memory::HEAP_VADDR + offset, read.data(), read.size());
+    REQUIRE(read == data);
+
+    constexpr u32 copy_src = half_size - Memory::PAGE_SIZE;
+    memory.CopyBlock(*process, Memory::HEAP_VADDR, Memory::HEAP_VADDR + copy_src,
+                     2 * Memory::PAGE_SIZE);
+    for (u32 i = 0; i < 2 * Memory::PAGE_SIZE; ++i) {
+        REQUIRE(BackingAt(i) == data[copy_src - offset + i]);
+    }
+
+    memory.ZeroBlock(*process, Memory::HEAP_VADDR + half_size - offset, 2 * offset);
+    for (u32 i = half_size - offset; i < half_size + offset; ++i) {
+        REQUIRE(BackingAt(i) == 0);
+    }
+    REQUIRE(BackingAt(half_size + offset) == data[half_size]);
+}
+
+TEST_CASE("Memory::MemorySystem write tracking", "[core][memory]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    memory.SetCurrentPageTable(&process->vm_manager.page_table);
+
+    constexpr u32 fcram_offset = 0x100000;
+    constexpr u32 size = 4 * Memory::PAGE_SIZE;
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR, memory.GetFCRAMPointer(fcram_offset), size,
+                                  Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+
+    memory.SetWriteTracking(true);
+    REQUIRE(memory.CollectDirtyPages().empty());
+
+    // Reads leave the pages clean
+    memory.Write32(Memory::HEAP_VADDR + Memory::PAGE_SIZE + 8, 0x12345678);
+    REQUIRE(memory.Read32(Memory::HEAP_VADDR + Memory::PAGE_SIZE + 8) == 0x12345678);
+    REQUIRE(memory.Read8(Memory::HEAP_VADDR) == 0);
+
+    const u32 data = 0xCAFE;
+    memory.WriteBlock(*process, Memory::HEAP_VADDR + 3 * Memory::PAGE_SIZE - 2, &data,
+                      sizeof(data));
+
+    constexpr PAddr paddr = Memory::FCRAM_PADDR + fcram_offset;
+    REQUIRE(memory.CollectDirtyPages() == std::vector<PAddr>{paddr + Memory::PAGE_SIZE,
+                                                             paddr + 2 * Memory::PAGE_SIZE,
+                                                             paddr + 3 * Memory::PAGE_SIZE});
+    REQUIRE(memory.CollectDirtyPages().empty());
+
+    // Collecting protects the pages again
+    memory.Write8(Memory::HEAP_VADDR + Memory::PAGE_SIZE, 1);
+    REQUIRE(memory.CollectDirtyPages() == std::vector<PAddr>{paddr + Memory::PAGE_SIZE});
+
+    // Only the pointers handed out for writing mark the pages dirty
+    REQUIRE(*memory.GetReadPointer(Memory::HEAP_VADDR + Memory::PAGE_SIZE + 8) == 0x78);
+    REQUIRE(memory.CollectDirtyPages().empty());
+    *memory.GetPointer(Memory::HEAP_VADDR + 2 * Memory::PAGE_SIZE) = 2;
+    REQUIRE(memory.Read8(Memory::HEAP_VADDR + 2 * Memory::PAGE_SIZE) == 2);
+    REQUIRE(memory.CollectDirtyPages() == std::vector<PAddr>{paddr + 2 * Memory::PAGE_SIZE});
+
+    // Writes bypassing the page tables are marked by physical address
+    memory.MarkRegionDirty(paddr + Memory::PAGE_SIZE - 1, 2);
+    REQUIRE(memory.CollectDirtyPages() == std::vector<PAddr>{paddr, paddr + Memory::PAGE_SIZE});
+
+    memory.SetWriteTracking(false);
+    memory.Write8(Memory::HEAP_VADDR, 1);
+    REQUIRE(memory.CollectDirtyPages().empty());
+    REQUIRE(memory.GetFCRAMPointer(fcram_offset)[0] == 1);
+}
+
+TEST_CASE("Memory::MemorySystem watched pages", "[core][memory]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    memory.SetCurrentPageTable(&process->vm_manager.page_table);
+
+    std::vector<u8> backing(2 * Memory::PAGE_SIZE);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR, backing.data(), backing.size(),
+                                  Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+
+    auto& page_table = process->vm_manager.page_table;
+    constexpr u32 page = Memory::HEAP_VADDR >> Memory::PAGE_BITS;
+    memory.SetPagesWatched(page_table, Memory::HEAP_VADDR + 8, 4, true);
+
+    // Only the page holding the watchpoint loses its fast path
+    REQUIRE(page_table.attributes[page] == Memory::PageType::WatchedMemory);
+    REQUIRE(page_table.pointers[page] == nullptr);
+    REQUIRE(page_table.pointers[page + 1] == backing.data() + Memory::PAGE_SIZE);
+
+    memory.Write32(Memory::HEAP_VADDR + 8, 0x12345678);
+    REQUIRE(memory.Read32(Memory::HEAP_VADDR + 8) == 0x12345678);
+    const u32 data = 0xCAFE;
+    memory.WriteBlock(*process, Memory::HEAP_VADDR + Memory::PAGE_SIZE - 2, &data, sizeof(data));
+    u32 read = 0;
+    memory.ReadBlock(*process, Memory::HEAP_VADDR + Memory::PAGE_SIZE - 2, &read, sizeof(read));
+    REQUIRE(read == data);
+
+    memory.SetPagesWatched(page_table, Memory::HEAP_VADDR + 8, 4, false);
+    REQUIRE(page_table.attributes[page] == Memory::PageType::Memory);
+    REQUIRE(page_table.pointers[page] == backing.data());
+    REQUIRE(page_table.tracked_pointers.empty());
+}
+
+TEST_CASE("Memory::MemorySystem host spans", "[core][memory]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    memory.SetCurrentPageTable(&process->vm_manager.page_table);
+
+    // Two contiguous pages followed by one mapped elsewhere in FCRAM
+    constexpr u32 size = 3 * Memory::PAGE_SIZE;
+    u8* const fcram = memory.GetFCRAMPointer(0x100000);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR, fcram, 2 * Memory::PAGE_SIZE,
+                                  Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR + 2 * Memory::PAGE_SIZE,
+                                  fcram + 4 * Memory::PAGE_SIZE, Memory::PAGE_SIZE,
+                                  Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+
+    Memory::ScatterList spans;
+    REQUIRE(memory.GetHostSpans(*process, Memory::HEAP_VADDR + 8, size - 8, false, spans));
+    REQUIRE(spans.size() == 2);
+    REQUIRE(spans[0].data == fcram + 8);
+    REQUIRE(spans[0].size == 2 * Memory::PAGE_SIZE - 8);
+    REQUIRE(spans[1].data == fcram + 4 * Memory::PAGE_SIZE);
+    REQUIRE(spans[1].size == Memory::PAGE_SIZE);
+
+    // Writing through the spans is seen as a write to the pages
+    memory.SetWriteTracking(true);
+    memory.CollectDirtyPages();
+    REQUIRE(memory.GetHostSpans(*process, Memory::HEAP_VADDR + size - 4, 4, true, spans));
+    REQUIRE(spans.size() == 1);
+    memory.HostSpansWritten(*process, Memory::HEAP_VADDR + size - 4, 4);
+    REQUIRE(memory.CollectDirtyPages() ==
+            std::vector<PAddr>{Memory::FCRAM_PADDR + 0x100000 + 4 * Memory::PAGE_SIZE});
+    memory.SetWriteTracking(false);
+
+    REQUIRE_FALSE(memory.GetHostSpans(*process, Memory::HEAP_VADDR + size - 4, 8, false, spans));
+}
+
+// Not run by default, use "[benchmark]" to select it
+TEST_CASE("Memory::MemorySystem block operations benchmark", "[.][benchmark][core][memory]") {
+    Core::Timing timing;
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+
+    constexpr u32 size = 16 * 1024 * 1024;
+    std::vector<u8> backing(size);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR, backing.data(), size,
+                                  Kernel::MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+
+    std::vector<u8> buffer(size / 2, 0x5A);
+    auto Measure = [](const char* name, auto&& operation) {
+        constexpr int iterations = 64;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            operation();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        WARN(name << ": " << (iterations * (size / 2) / (1024.0 * 1024.0)) / seconds << " MiB/s");
+    };
+
+    Measure("ReadBlock", [&] {
+        memory.ReadBlock(*process, Memory::HEAP_VADDR, buffer.data(), buffer.size());
+    });
+    Measure("WriteBlock", [&] {
+        memory.WriteBlock(*process, Memory::HEAP_VADDR, buffer.data(), buffer.size());
+    });
+    Measure("ZeroBlock", [&] { memory.ZeroBlock(*process, Memory::HEAP_VADDR, size / 2); });
+    Measure("CopyBlock", [&] {
+        memory.CopyBlock(*process, Memory::HEAP_VADDR + size / 2, Memory::HEAP_VADDR, size / 2);
+    });
+    REQUIRE(std::memcmp(backing.data(), backing.data() + size / 2, size / 2) == 0);
+}
@@ -0,0 +1,187 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/geometry_pipeline.h"
+#include "video_core/pica_state.h"
+#include "video_core/regs.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+
+namespace {
+
+using Shader::AttributeBuffer;
+using Shader::EmittedPrimitive;
+
+/// Number of vertices in an input primitive of the test geometry shader
+constexpr unsigned INPUT_VERTEX_NUM = 3;
+
+/// First uniform register receiving the input in FixedPrimitive mode
+constexpr unsigned UNIFORM_START_INDEX = 8;
+
+/// Number of input primitives of a draw, more than fit in a batch and not a multiple of it
+constexpr unsigned PRIMITIVE_NUM = 150;
+
+/**
+ * Stands in for a geometry shader program: emits a triangle made of its input vertices, followed by
+ * a reversed copy of it for every third input primitive. Each output vertex also carries the value
+ * of b15, which tells the program whether it is the first invocation of a draw.
+ */
+class TestShaderEngine final : public Shader::ShaderEngine {
+public:
+    explicit TestShaderEngine(bool input_to_uniform) : input_to_uniform(input_to_uniform) {}
+
+    void SetupBatch(Shader::ShaderSetup& setup, unsigned int entry_point) override {}
+
+    void Run(const Shader::ShaderSetup& setup, Shader::UnitState& state) const override {
+        const Common::Vec4<float24>* input = input_to_uniform
+                                                 ? setup.uniforms.f + UNIFORM_START_INDEX
+                                                 : state.registers.input;
+        const float24 b15 = float24::FromFloat32(setup.uniforms.b[15] ? 1.0f : 0.0f);
+        const int first_vertex = static_cast<int>(input[0].x.ToFloat32());
+        Shader::GSEmitter& emitter = *state.emitter_ptr;
+
+        const auto emit_triangle = [&](bool reverse, bool winding) {
+            for (unsigned i = 0; i < INPUT_VERTEX_NUM; ++i) {
+                const unsigned vertex = reverse ? INPUT_VERTEX_NUM - 1 - i : i;
+                emitter.vertex_id = static_cast<u8>(i);
+                emitter.prim_emit = i == INPUT_VERTEX_NUM - 1;
+                emitter.winding = winding;
+                state.registers.output[0] = input[vertex];
+                state.registers.output[1] = Common::MakeVec(b15, b15, b15, b15);
+                emitter.Emit(state.registers.output);
+            }
+        };
+        emit_triangle(false, false);
+        if (first_vertex % (3 * INPUT_VERTEX_NUM) == 0)
+            emit_triangle(true, true);
+    }
+
+private:
+    bool input_to_uniform;
+};
+
+AttributeBuffer MakeVertex(unsigned index) {
+    AttributeBuffer vertex{};
+    const float value = static_cast<float>(index);
+    vertex.attr[0] = Common::MakeVec(float24::FromFloat32(value), float24::FromFloat32(value / 2),
+                                     float24::FromFloat32(-value), float24::FromFloat32(1.0f));
+    return vertex;
+}
+
+/// Configures the registers for a geometry shader taking one attribute from each input vertex
+void SetupRegs(Regs& regs, PipelineRegs::GSMode mode) {
+    regs.pipeline.use_gs.Assign(PipelineRegs::UseGS::Yes);
+    regs.pipeline.gs_unit_exclusive_configuration.Assign(1);
+    regs.pipeline.vs_outmap_total_minus_1_a.Assign(0);
+    regs.pipeline.vs_outmap_total_minus_1_b.Assign(0);
+    regs.pipeline.gs_config.mode.Assign(mode);
+    regs.gs.shader_mode.Assign(ShaderRegs::ShaderMode::GS);
+    regs.gs.output_mask.Assign(0b11);
+
+    if (mode == PipelineRegs::GSMode::Point) {
+        regs.gs.max_input_attribute_index.Assign(INPUT_VERTEX_NUM - 1);
+        regs.gs.input_attribute_to_register_map_low = 0x76543210;
+        regs.gs.input_attribute_to_register_map_high = 0xFEDCBA98;
+    } else {
+        regs.gs.input_to_uniform.Assign(1);
+        regs.pipeline.gs_config.fixed_vertex_num_minus_1.Assign(INPUT_VERTEX_NUM - 1);
+        regs.pipeline.gs_config.stride_minus_1.Assign(0);
+        regs.pipeline.gs_config.start_index.Assign(UNIFORM_START_INDEX);
+    }
+}
+
+/// Invokes the geometry shader as soon as each input primitive is complete, one at a time
+std::vector<EmittedPrimitive> RunSerial(State& state, const Shader::ShaderEngine& engine,
+                                        bool input_to_uniform) {
+    auto unit = std::make_unique<Shader::GSUnitState>();
+    unit->ConfigOutput(state.regs.gs);
+    state.gs.uniforms.b[15] = false;
+
+    for (unsigned primitive = 0; primitive < PRIMITIVE_NUM; ++primitive) {
+        for (unsigned i = 0; i < INPUT_VERTEX_NUM; ++i) {
+            const AttributeBuffer vertex = MakeVertex(primitive * INPUT_VERTEX_NUM + i);
+            if (input_to_uniform)
+                state.gs.uniforms.f[UNIFORM_START_INDEX + i] = vertex.attr[0];
+            else
+                unit->registers.input[i] = vertex.attr[0];
+        }
+        engine.Run(state.gs, *unit);
+        state.gs.uniforms.b[15] = true;
+    }
+    return *unit->emitter.emitted_primitives;
+}
+
+/// Sends the input vertices through the geometry pipeline, which batches the invocations
+std::vector<EmittedPrimitive> RunPipeline(State& state, Shader::ShaderEngine& engine) {
+    std::vector<EmittedPrimitive> output;
+    std::size_t batch_num = 0;
+    state.geometry_pipeline.SetPrimitiveHandler(
+        [&output, &batch_num](const std::vector<EmittedPrimitive>& primitives) {
+            output.insert(output.end(), primitives.begin(), primitives.end());
+            ++batch_num;
+        });
+    state.geometry_pipeline.Reconfigure();
+    state.geometry_pipeline.Setup(&engine);
+    state.gs.uniforms.b[15] = false;
+
+    for (unsigned vertex = 0; vertex < PRIMITIVE_NUM * INPUT_VERTEX_NUM; ++vertex)
+        state.geometry_pipeline.SubmitVertex(MakeVertex(vertex));
+    state.geometry_pipeline.Flush();
+
+    // The draw must have been split into several batches for the comparison to be meaningful
+    REQUIRE(batch_num > 1);
+    return output;
+}
+
+void RequireSameOutput(const std::vector<EmittedPrimitive>& serial,
+                       const std::vector<EmittedPrimitive>& batched) {
+    REQUIRE(batched.size() == serial.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        REQUIRE(batched[i].winding == serial[i].winding);
+        for (std::size_t v = 0; v < serial[i].vertices.size(); ++v) {
+            for (std::size_t attr = 0; attr < 2; ++attr) {
+                for (std::size_t comp = 0; comp < 4; ++comp) {
+                    REQUIRE(batched[i].vertices[v].attr[attr][comp].ToFloat32() ==
+                            serial[i].vertices[v].attr[attr][comp].ToFloat32());
+                }
+            }
+        }
+    }
+}
+
+void TestMode(PipelineRegs::GSMode mode) {
+    const bool input_to_uniform = mode != PipelineRegs::GSMode::Point;
+    TestShaderEngine engine(input_to_uniform);
+    auto state = std::make_unique<State>();
+    state->Reset();
+    SetupRegs(state->regs, mode);
+
+    const auto serial = RunSerial(*state, engine, input_to_uniform);
+    const auto batched = RunPipeline(*state, engine);
+    REQUIRE(serial.size() > PRIMITIVE_NUM);
+    RequireSameOutput(serial, batched);
+
+    // Only the first invocation of the draw sees b15 cleared
+    REQUIRE(batched.front().vertices[0].attr[1].x.ToFloat32() == 0.0f);
+    REQUIRE(batched.back().vertices[0].attr[1].x.ToFloat32() == 1.0f);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("GeometryPipeline batches match serial invocations in Point mode",
+          "[video_core][geometry_pipeline]") {
+    TestMode(PipelineRegs::GSMode::Point);
+}
+
+TEST_CASE("GeometryPipeline batches match serial invocations in FixedPrimitive mode",
+          "[video_core][geometry_pipeline]") {
+    TestMode(PipelineRegs::GSMode::FixedPrimitive);
+}
+
+} // namespace Pica
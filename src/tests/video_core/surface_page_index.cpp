@@ -0,0 +1,221 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+#include <boost/icl/interval_map.hpp>
+#include <catch2/catch.hpp>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_surface_page_index.h"
+
+namespace {
+
+/// A single rasterizer cache operation, as seen by the surface index
+struct TraceOp {
+    enum class Type { Register, Unregister, Lookup, Invalidate };
+    Type type;
+    u32 id;
+    PAddr addr;
+    u32 size;
+};
+
+/**
+ * Builds a deterministic trace resembling a few frames of a game: framebuffers in VRAM that are
+ * looked up every draw, textures in FCRAM that come and go, small CPU invalidations and large DMA
+ * invalidations.
+ */
+std::vector<TraceOp> GenerateTrace(std::size_t num_frames) {
+    constexpr PAddr VRAM = 0x18000000;
+    constexpr PAddr FCRAM = 0x20000000;
+    std::mt19937 rng(0x3D5);
+
+    std::vector<TraceOp> trace;
+    u32 next_id = 0;
+    struct Live {
+        u32 id;
+        PAddr addr;
+        u32 size;
+    };
+    std::vector<Live> live;
+
+    auto Register = [&](PAddr addr, u32 size) {
+        live.push_back({next_id, addr, size});
+        trace.push_back({TraceOp::Type::Register, next_id++, addr, size});
+    };
+
+    // Color and depth buffers for both screens
+    Register(VRAM, 400 * 240 * 4);
+    Register(VRAM + 0x100000, 400 * 240 * 4);
+    Register(VRAM + 0x200000, 320 * 240 * 4);
+    Register(VRAM + 0x300000, 320 * 240 * 4);
+
+    std::uniform_int_distribution<u32> texture_slot(0, 0x3FF);
+    std::uniform_int_distribution<u32> texture_size_log2(10, 17);
+    std::uniform_int_distribution<u32> percent(0, 99);
+
+    for (std::size_t frame = 0; frame < num_frames; ++frame) {
+        for (int draw = 0; draw < 200; ++draw) {
+            trace.push_back({TraceOp::Type::Lookup, 0, VRAM, 400 * 240 * 4});
+            trace.push_back({TraceOp::Type::Lookup, 0, VRAM + 0x100000, 400 * 240 * 4});
+
+            const PAddr texture_addr = FCRAM + texture_slot(rng) * 0x4000;
+            const u32 texture_size = 1u << texture_size_log2(rng);
+            trace.push_back({TraceOp::Type::Lookup, 0, texture_addr, texture_size});
+            if (percent(rng) < 10)
+                Register(texture_addr, texture_size);
+
+            if (percent(rng) < 20) {
+                // CPU write to a texture or vertex buffer
+                const PAddr addr = FCRAM + texture_slot(rng) * 0x40;
+                trace.push_back({TraceOp::Type::Invalidate, 0, addr, 4});
+            }
+        }
+
+        // Display transfer out of the framebuffers and texture uploads through DMA
+        trace.push_back({TraceOp::Type::Invalidate, 0, VRAM + 0x200000, 320 * 240 * 4});
+        const PAddr dma_addr = FCRAM + texture_slot(rng) * 0x4000;
+        trace.push_back({TraceOp::Type::Invalidate, 0, dma_addr, 0x40000});
+
+        // Evict some textures
+        while (live.size() > 200) {
+            std::uniform_int_distribution<std::size_t> victim(4, live.size() - 1);
+            const std::size_t index = victim(rng);
+            trace.push_back({TraceOp::Type::Unregister, live[index].id, live[index].addr,
+                             live[index].size});
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+
+    return trace;
+}
+
+/// Reference implementation with the interval map previously used by the rasterizer cache
+class IntervalMapIndex {
+public:
+    void Insert(u32 id, PAddr addr, PAddr end) {
+        map.add({Interval::right_open(addr, end), std::set<u32>{id}});
+    }
+
+    void Erase(u32 id, PAddr addr, PAddr end) {
+        map.subtract({Interval::right_open(addr, end), std::set<u32>{id}});
+    }
+
+    template <typename Func>
+    void ForEachOverlapping(PAddr addr, PAddr end, Func&& func) const {
+        for (auto& pair : boost::make_iterator_range(
+                 map.equal_range(Interval::right_open(addr, end)))) {
+            for (u32 id : pair.second) {
+                func(id);
+            }
+        }
+    }
+
+private:
+    using Map = boost::icl::interval_map<PAddr, std::set<u32>>;
+    using Interval = Map::interval_type;
+    Map map;
+};
+
+/// Replays the trace, passing the overlapping ids of every lookup and invalidation to on_query
+template <typename Index, typename Callback>
+void Replay(Index& index, const std::vector<TraceOp>& trace, Callback&& on_query) {
+    std::vector<u32> result;
+    for (const TraceOp& op : trace) {
+        switch (op.type) {
+        case TraceOp::Type::Register:
+            index.Insert(op.id, op.addr, op.addr + op.size);
+            break;
+        case TraceOp::Type::Unregister:
+            index.Erase(op.id, op.addr, op.addr + op.size);
+            break;
+        case TraceOp::Type::Lookup:
+        case TraceOp::Type::Invalidate:
+            result.clear();
+            index.ForEachOverlapping(op.addr, op.addr + op.size,
+                                     [&result](u32 id) { result.push_back(id); });
+            on_query(result);
+            break;
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SurfacePageIndex matches interval map", "[video_core][rasterizer_cache]") {
+    const std::vector<TraceOp> trace = GenerateTrace(8);
+
+    std::vector<std::vector<u32>> expected;
+    IntervalMapIndex reference;
+    Replay(reference, trace, [&expected](const std::vector<u32>& result) {
+        // The interval map reports a surface once per segment it is split into
+        std::vector<u32> ids = result;
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        expected.push_back(std::move(ids));
+    });
+
+    std::size_t query = 0;
+    OpenGL::SurfacePageIndex<u32> index;
+    Replay(index, trace, [&](const std::vector<u32>& result) {
+        std::vector<u32> ids = result;
+        std::sort(ids.begin(), ids.end());
+        // Every overlapping surface must be reported exactly once
+        REQUIRE(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+        REQUIRE(ids == expected[query++]);
+    });
+    REQUIRE(query == expected.size());
+}
+
+TEST_CASE("SurfacePageIndex covers whole address space queries", "[video_core][rasterizer_cache]") {
+    OpenGL::SurfacePageIndex<u32> index;
+    index.Insert(1, 0x18000000, 0x18001000);
+    index.Insert(2, 0x20000FFC, 0x20001004);
+    index.Insert(3, 0xFFFFF000, 0xFFFFFFFF);
+
+    std::vector<u32> ids;
+    index.ForEachOverlapping(0, 0xFFFFFFFF, [&ids](u32 id) { ids.push_back(id); });
+    std::sort(ids.begin(), ids.end());
+    REQUIRE(ids == std::vector<u32>{1, 2, 3});
+
+    ids.clear();
+    index.ForEachOverlapping(0x20001000, 0x20001001, [&ids](u32 id) { ids.push_back(id); });
+    REQUIRE(ids == std::vector<u32>{2});
+
+    ids.clear();
+    index.ForEachOverlapping(0x18001000, 0x20000FFC, [&ids](u32 id) { ids.push_back(id); });
+    REQUIRE(ids.empty());
+
+    index.Erase(2, 0x20000FFC, 0x20001004);
+    index.Erase(1, 0x18000000, 0x18001000);
+    REQUIRE(index.Front() == 3);
+    index.Erase(3, 0xFFFFF000, 0xFFFFFFFF);
+    REQUIRE(index.IsEmpty());
+}
+
+// Not run by default, use "[benchmark]" to select it
+TEST_CASE("SurfacePageIndex benchmark", "[.][benchmark][video_core][rasterizer_cache]") {
+    const std::vector<TraceOp> trace = GenerateTrace(60);
+
+    auto Measure = [&trace](auto& index) {
+        std::size_t total = 0;
+        const auto start = std::chrono::steady_clock::now();
+        Replay(index, trace, [&total](const std::vector<u32>& result) { total += result.size(); });
+        const auto end = std::chrono::steady_clock::now();
+        return std::make_pair(std::chrono::duration<double, std::milli>(end - start).count(),
+                              total);
+    };
+
+    IntervalMapIndex reference;
+    OpenGL::SurfacePageIndex<u32> index;
+    const auto reference_result = Measure(reference);
+    const auto index_result = Measure(index);
+
+    WARN("Replayed " << trace.size() << " operations: interval map " << reference_result.first
+                     << " ms, page index " << index_result.first << " ms");
+    REQUIRE(index_result.second <= reference_result.second);
+}
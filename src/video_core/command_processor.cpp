@@ -244,6 +244,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     ASSERT(!g_state.geometry_pipeline.NeedIndexInput());
                     g_state.geometry_pipeline.Setup(shader_engine);
                     g_state.geometry_pipeline.SubmitVertex(output);
+                    g_state.geometry_pipeline.Flush();
 
                     // TODO: If drawing after every immediate mode triangle kills performance,
                     // change it to flush triangles whenever a drawing config register changes
@@ -422,6 +423,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             // Send to geometry pipeline
             g_state.geometry_pipeline.SubmitVertex(vs_output);
         }
+        g_state.geometry_pipeline.Flush();
 
         for (auto& range : memory_accesses.ranges) {
             g_debug_context->recorder->MemoryAccessed(
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <vector>
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs.h"
@@ -10,6 +12,9 @@
 
 namespace Pica {
 
+/// Maximum number of complete input primitives gathered before the geometry shader is invoked
+constexpr std::size_t GS_BATCH_SIZE = 64;
+
 /// An attribute buffering interface for different pipeline modes
 class GeometryPipelineBackend {
 public:
@@ -27,9 +32,18 @@ public:
     /**
      * Submits vertex attributes
      * @param input attributes of a vertex output from vertex shader
-     * @return if the buffer is full and the geometry shader should be invoked
+     * @return if the batch is full and the geometry shader should be invoked
      */
     virtual bool SubmitVertex(const Shader::AttributeBuffer& input) = 0;
+
+    /// Returns the number of complete input primitives waiting for the geometry shader
+    virtual std::size_t GetPendingPrimitiveCount() const = 0;
+
+    /// Loads the pending input primitive with the given index into the geometry shader unit
+    virtual void LoadPrimitive(std::size_t index) = 0;
+
+    /// Discards all pending input primitives after the geometry shader has processed them
+    virtual void ClearPendingPrimitives() = 0;
 };
 
 // In the Point mode, vertex attributes are sent to the input registers in the geometry shader unit.
@@ -38,20 +52,22 @@ public:
 // shader that takes 6 inputs, and the vertex shader outputs 2 attributes, it would take 3 vertices
 // for one geometry shader invocation.
 // TODO: what happens when the input size is not divisible by the output size?
+// Complete inputs are gathered into a batch of attribute buffers, which are loaded into the input
+// registers one by one when the batch is run.
 class GeometryPipeline_Point : public GeometryPipelineBackend {
 public:
-    GeometryPipeline_Point(const Regs& regs, Shader::GSUnitState& unit) : regs(regs), unit(unit) {
+    GeometryPipeline_Point(const Regs& regs, Shader::GSUnitState& unit)
+        : regs(regs), unit(unit), batch(GS_BATCH_SIZE) {
         ASSERT(regs.pipeline.variable_primitive == 0);
         ASSERT(regs.gs.input_to_uniform == 0);
         vs_output_num = regs.pipeline.vs_outmap_total_minus_1_a + 1;
-        std::size_t gs_input_num = regs.gs.max_input_attribute_index + 1;
+        gs_input_num = regs.gs.max_input_attribute_index + 1;
         ASSERT(gs_input_num % vs_output_num == 0);
-        buffer_cur = attribute_buffer.attr;
-        buffer_end = attribute_buffer.attr + gs_input_num;
+        StartPrimitive();
     }
 
     bool IsEmpty() const override {
-        return buffer_cur == attribute_buffer.attr;
+        return buffer_cur == batch[batch_count].attr;
     }
 
     bool NeedIndexInput() const override {
@@ -65,25 +81,47 @@ public:
     bool SubmitVertex(const Shader::AttributeBuffer& input) override {
         buffer_cur = std::copy(input.attr, input.attr + vs_output_num, buffer_cur);
         if (buffer_cur == buffer_end) {
-            buffer_cur = attribute_buffer.attr;
-            unit.LoadInput(regs.gs, attribute_buffer);
-            return true;
+            ++batch_count;
+            if (batch_count == batch.size())
+                return true;
+            StartPrimitive();
         }
         return false;
     }
 
+    std::size_t GetPendingPrimitiveCount() const override {
+        return batch_count;
+    }
+
+    void LoadPrimitive(std::size_t index) override {
+        unit.LoadInput(regs.gs, batch[index]);
+    }
+
+    void ClearPendingPrimitives() override {
+        batch_count = 0;
+        StartPrimitive();
+    }
+
 private:
+    void StartPrimitive() {
+        buffer_cur = batch[batch_count].attr;
+        buffer_end = buffer_cur + gs_input_num;
+    }
+
     const Regs& regs;
     Shader::GSUnitState& unit;
-    Shader::AttributeBuffer attribute_buffer;
+    std::vector<Shader::AttributeBuffer> batch;
+    std::size_t batch_count = 0;
     Common::Vec4<float24>* buffer_cur;
     Common::Vec4<float24>* buffer_end;
     unsigned int vs_output_num;
+    std::size_t gs_input_num;
 };
 
 // In VariablePrimitive mode, vertex attributes are buffered into the uniform registers in the
 // geometry shader unit. The number of vertex is variable, which is specified by the first index
-// value in the batch. This mode is usually used for subdivision.
+// value in the batch. This mode is usually used for subdivision. As the input size varies and may
+// cover most of the uniform registers, the geometry shader is invoked for every single primitive.
 class GeometryPipeline_VariablePrimitive : public GeometryPipelineBackend {
 public:
     GeometryPipeline_VariablePrimitive(const Regs& regs, Shader::ShaderSetup& setup)
@@ -130,14 +168,29 @@ public:
 
         if (total_vertex_num == 0) {
             need_index = true;
+            primitive_ready = true;
             return true;
         }
 
         return false;
     }
 
+    std::size_t GetPendingPrimitiveCount() const override {
+        return primitive_ready ? 1 : 0;
+    }
+
+    void LoadPrimitive(std::size_t index) override {
+        // The input has already been written to the uniform registers
+        DEBUG_ASSERT(index == 0);
+    }
+
+    void ClearPendingPrimitives() override {
+        primitive_ready = false;
+    }
+
 private:
     bool need_index = true;
+    bool primitive_ready = false;
     const Regs& regs;
     Shader::ShaderSetup& setup;
     unsigned int main_vertex_num;
@@ -148,7 +201,8 @@ private:
 
 // In FixedPrimitive mode, vertex attributes are buffered into the uniform registers in the geometry
 // shader unit. The number of vertex per shader invocation is constant. This is usually used for
-// particle system.
+// particle system. Complete inputs are gathered into a flat batch buffer, and each of them is
+// copied to the uniform registers right before its geometry shader invocation.
 class GeometryPipeline_FixedPrimitive : public GeometryPipelineBackend {
 public:
     GeometryPipeline_FixedPrimitive(const Regs& regs, Shader::ShaderSetup& setup)
@@ -158,8 +212,11 @@ public:
         vs_output_num = regs.pipeline.vs_outmap_total_minus_1_a + 1;
         ASSERT(vs_output_num == regs.pipeline.gs_config.stride_minus_1 + 1);
         std::size_t vertex_num = regs.pipeline.gs_config.fixed_vertex_num_minus_1 + 1;
-        buffer_cur = buffer_begin = setup.uniforms.f + regs.pipeline.gs_config.start_index;
-        buffer_end = buffer_begin + vs_output_num * vertex_num;
+        uniform_begin = setup.uniforms.f + regs.pipeline.gs_config.start_index;
+        primitive_size = vs_output_num * vertex_num;
+        batch.resize(primitive_size * GS_BATCH_SIZE);
+        buffer_cur = buffer_begin = batch.data();
+        buffer_end = buffer_begin + primitive_size;
     }
 
     bool IsEmpty() const override {
@@ -177,15 +234,37 @@ public:
     bool SubmitVertex(const Shader::AttributeBuffer& input) override {
         buffer_cur = std::copy(input.attr, input.attr + vs_output_num, buffer_cur);
         if (buffer_cur == buffer_end) {
-            buffer_cur = buffer_begin;
-            return true;
+            ++batch_count;
+            if (batch_count == GS_BATCH_SIZE)
+                return true;
+            buffer_begin = buffer_end;
+            buffer_end += primitive_size;
         }
         return false;
     }
 
+    std::size_t GetPendingPrimitiveCount() const override {
+        return batch_count;
+    }
+
+    void LoadPrimitive(std::size_t index) override {
+        const Common::Vec4<float24>* primitive = batch.data() + index * primitive_size;
+        std::copy(primitive, primitive + primitive_size, uniform_begin);
+    }
+
+    void ClearPendingPrimitives() override {
+        batch_count = 0;
+        buffer_cur = buffer_begin = batch.data();
+        buffer_end = buffer_begin + primitive_size;
+    }
+
 private:
     const Regs& regs;
     Shader::ShaderSetup& setup;
+    std::vector<Common::Vec4<float24>> batch;
+    std::size_t batch_count = 0;
+    std::size_t primitive_size;
+    Common::Vec4<float24>* uniform_begin;
     Common::Vec4<float24>* buffer_begin;
     Common::Vec4<float24>* buffer_cur;
     Common::Vec4<float24>* buffer_end;
@@ -200,6 +279,10 @@ void GeometryPipeline::SetVertexHandler(Shader::VertexHandler vertex_handler) {
     this->vertex_handler = vertex_handler;
 }
 
+void GeometryPipeline::SetPrimitiveHandler(Shader::PrimitiveHandler primitive_handler) {
+    this->primitive_handler = primitive_handler;
+}
+
 void GeometryPipeline::Setup(Shader::ShaderEngine* shader_engine) {
     if (!backend)
         return;
@@ -209,7 +292,7 @@ void GeometryPipeline::Setup(Shader::ShaderEngine* shader_engine) {
 }
 
 void GeometryPipeline::Reconfigure() {
-    ASSERT(!backend || backend->IsEmpty());
+    ASSERT(!backend || (backend->IsEmpty() && backend->GetPendingPrimitiveCount() == 0));
 
     if (state.regs.pipeline.use_gs == PipelineRegs::UseGS::No) {
         backend = nullptr;
@@ -261,14 +344,35 @@ void GeometryPipeline::SubmitVertex(const Shader::AttributeBuffer& input) {
         vertex_handler(input);
     } else {
         if (backend->SubmitVertex(input)) {
-            shader_engine->Run(state.gs, state.gs_unit);
-
-            // The uniform b15 is set to true after every geometry shader invocation. This is useful
-            // for the shader to know if this is the first invocation in a batch, if the program set
-            // b15 to false first.
-            state.gs.uniforms.b[15] = true;
+            RunBatch();
         }
     }
 }
 
+void GeometryPipeline::Flush() {
+    if (backend) {
+        RunBatch();
+    }
+}
+
+void GeometryPipeline::RunBatch() {
+    const std::size_t count = backend->GetPendingPrimitiveCount();
+    for (std::size_t i = 0; i < count; ++i) {
+        backend->LoadPrimitive(i);
+        shader_engine->Run(state.gs, state.gs_unit);
+
+        // The uniform b15 is set to true after every geometry shader invocation. This is useful
+        // for the shader to know if this is the first invocation in a batch, if the program set
+        // b15 to false first.
+        state.gs.uniforms.b[15] = true;
+    }
+    backend->ClearPendingPrimitives();
+
+    auto& emitted_primitives = *state.gs_unit.emitter.emitted_primitives;
+    if (!emitted_primitives.empty()) {
+        primitive_handler(emitted_primitives);
+        emitted_primitives.clear();
+    }
+}
+
 } // namespace Pica
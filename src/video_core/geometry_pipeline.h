@@ -22,6 +22,9 @@ public:
     /// Sets the handler for receiving vertex outputs from vertex shader
     void SetVertexHandler(Shader::VertexHandler vertex_handler);
 
+    /// Sets the handler for receiving batches of primitives emitted by geometry shader
+    void SetPrimitiveHandler(Shader::PrimitiveHandler primitive_handler);
+
     /**
      * Setup the geometry shader unit if it is in use
      * @param shader_engine the shader engine for the geometry shader to run
@@ -40,8 +43,18 @@ public:
     /// Submits vertex attributes output from vertex shader
     void SubmitVertex(const Shader::AttributeBuffer& input);
 
+    /**
+     * Runs the geometry shader over all complete input primitives that are still pending and sends
+     * the emitted primitives to the primitive handler. Call this before the end of a draw call.
+     */
+    void Flush();
+
 private:
+    /// Invokes the geometry shader for each pending input primitive and drains the output buffer
+    void RunBatch();
+
     Shader::VertexHandler vertex_handler;
+    Shader::PrimitiveHandler primitive_handler;
     Shader::ShaderEngine* shader_engine;
     std::unique_ptr<GeometryPipelineBackend> backend;
     State& state;
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <vector>
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
@@ -37,10 +38,19 @@ State::State() : geometry_pipeline(*this) {
             Shader::OutputVertex::FromAttributeBuffer(regs.rasterizer, vertex), AddTriangle);
     };
 
-    auto SetWinding = [this]() { primitive_assembler.SetWinding(); };
+    using PrimitiveList = std::vector<Shader::EmittedPrimitive>;
+    auto SubmitPrimitives = [this, SubmitVertex](const PrimitiveList& primitives) {
+        for (const auto& primitive : primitives) {
+            if (primitive.winding)
+                primitive_assembler.SetWinding();
+            for (const auto& vertex : primitive.vertices) {
+                SubmitVertex(vertex);
+            }
+        }
+    };
 
-    g_state.gs_unit.SetVertexHandler(SubmitVertex, SetWinding);
     g_state.geometry_pipeline.SetVertexHandler(SubmitVertex);
+    g_state.geometry_pipeline.SetPrimitiveHandler(SubmitPrimitives);
 }
 
 void State::Reset() {
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include "common/common_types.h"
 #include "core/hw/gpu.h"
 
@@ -17,6 +19,13 @@ struct OutputVertex;
 
 namespace VideoCore {
 
+enum class LoadCallbackStage {
+    Prepare,
+    Build,
+    Complete,
+};
+using DiskResourceLoadCallback = std::function<void(LoadCallbackStage, std::size_t, std::size_t)>;
+
 class RasterizerInterface {
 public:
     virtual ~RasterizerInterface() {}
@@ -71,5 +80,9 @@ public:
     virtual bool AccelerateDrawBatch(bool is_indexed) {
         return false;
     }
+
+    /// Loads resources cached on disk for the running title, reporting progress to callback
+    virtual void LoadDiskResources(const std::atomic_bool& stop_loading,
+                                   const DiskResourceLoadCallback& callback) {}
 };
 } // namespace VideoCore
@@ -155,7 +155,7 @@ RasterizerOpenGL::RasterizerOpenGL(EmuWindow& window)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer.GetHandle());
 
     shader_program_manager =
-        std::make_unique<ShaderProgramManager>(GLAD_GL_ARB_separate_shader_objects, is_amd);
+        std::make_unique<ShaderProgramManager>(GLAD_GL_ARB_separate_shader_objects, is_amd, window);
 
     glEnable(GL_BLEND);
 
@@ -388,6 +388,11 @@ bool RasterizerOpenGL::SetupGeometryShader() {
     }
 }
 
+void RasterizerOpenGL::LoadDiskResources(const std::atomic_bool& stop_loading,
+                                         const VideoCore::DiskResourceLoadCallback& callback) {
+    shader_program_manager->LoadDiskCache(stop_loading, callback);
+}
+
 bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
     const auto& regs = Pica::g_state.regs;
     if (regs.pipeline.use_gs != Pica::PipelineRegs::UseGS::No) {
@@ -762,10 +767,9 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
         }
     }
 
-    // Sync and bind the shader
+    // Sync and bind the shader. The shader stays dirty while it is being built in the background.
     if (shader_dirty) {
-        SetShader();
-        shader_dirty = false;
+        shader_dirty = !SetShader();
     }
 
     // Sync the LUTs within the texture buffer
@@ -786,9 +790,11 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     state.scissor.height = draw_rect.GetHeight();
     state.Apply();
 
-    // Draw the vertex batch
+    // Draw the vertex batch, unless its shader isn't ready yet
     bool succeeded = true;
-    if (accelerate) {
+    if (shader_dirty) {
+        LOG_TRACE(Render_OpenGL, "Skipping draw while its fragment shader is being built");
+    } else if (accelerate) {
         succeeded = AccelerateDrawBatchInternal(is_indexed, use_gs);
     } else {
         state.draw.vertex_array = sw_vao.handle;
@@ -1631,9 +1637,9 @@ void RasterizerOpenGL::SamplerInfo::SyncWithConfig(
     }
 }
 
-void RasterizerOpenGL::SetShader() {
+bool RasterizerOpenGL::SetShader() {
     auto config = PicaFSConfig::BuildFromRegs(Pica::g_state.regs);
-    shader_program_manager->UseFragmentShader(config);
+    return shader_program_manager->UseFragmentShader(config);
 }
 
 void RasterizerOpenGL::SyncClipEnabled() {
@@ -53,6 +53,8 @@ public:
     bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr,
                            u32 pixel_stride, ScreenInfo& screen_info) override;
     bool AccelerateDrawBatch(bool is_indexed) override;
+    void LoadDiskResources(const std::atomic_bool& stop_loading,
+                           const VideoCore::DiskResourceLoadCallback& callback) override;
 
 private:
     struct SamplerInfo {
@@ -134,8 +136,11 @@ private:
     /// Syncs the clip coefficients to match the PICA register
     void SyncClipCoef();
 
-    /// Sets the OpenGL shader in accordance with the current PICA register state
-    void SetShader();
+    /**
+     * Sets the OpenGL shader in accordance with the current PICA register state
+     * @returns false if the shader is not ready yet
+     */
+    bool SetShader();
 
     /// Syncs the cull mode to match the PICA register
     void SyncCullMode();
@@ -29,6 +29,7 @@
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_surface_page_index.h"
 #include "video_core/texture/texture_decode.h"
 
 namespace OpenGL {
@@ -81,11 +82,10 @@ using SurfaceSet = std::set<Surface>;
 
 using SurfaceRegions = boost::icl::interval_set<PAddr>;
 using SurfaceMap = boost::icl::interval_map<PAddr, Surface>;
-using SurfaceCache = boost::icl::interval_map<PAddr, SurfaceSet>;
+using SurfaceCache = SurfacePageIndex<Surface>;
 
-using SurfaceInterval = SurfaceCache::interval_type;
-static_assert(std::is_same<SurfaceRegions::interval_type, SurfaceCache::interval_type>() &&
-                  std::is_same<SurfaceMap::interval_type, SurfaceCache::interval_type>(),
+using SurfaceInterval = SurfaceMap::interval_type;
+static_assert(std::is_same<SurfaceRegions::interval_type, SurfaceMap::interval_type>(),
               "incorrect interval types");
 
 using SurfaceRect_Tuple = std::tuple<Surface, Common::Rectangle<u32>>;
@@ -373,6 +373,13 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
     std::unique_ptr<u8[]> gl_buffer;
     std::size_t gl_buffer_size = 0;
 
+    /// Hash of the 3DS memory the whole texture was last loaded from, 0 if the texture has been
+    /// modified by other means since then (rendering, copies or partial loads)
+    u64 texture_hash = 0;
+
+    /// Hashes the 3DS memory of the surface, returns 0 if it can't be read in one piece
+    u64 ComputeMemoryHash() const;
+
     // Read/Write data in 3DS memory to/from gl_buffer
     void LoadGLBuffer(PAddr load_start, PAddr load_end);
     void FlushGLBuffer(PAddr flush_start, PAddr flush_end);
@@ -424,9 +431,20 @@ struct CachedTextureCube {
 
 class RasterizerCacheOpenGL : NonCopyable {
 public:
+    /// Outcome of the whole surface loads from 3DS memory
+    struct UploadStats {
+        u64 skipped = 0;  ///< The texture already held the same data
+        u64 shared = 0;   ///< The texture was copied from another one loaded from the same data
+        u64 uploaded = 0; ///< The data was converted and uploaded
+    };
+
     RasterizerCacheOpenGL();
     ~RasterizerCacheOpenGL();
 
+    const UploadStats& GetUploadStats() const {
+        return upload_stats;
+    }
+
     /// Blit one surface's texture to another
     bool BlitSurfaces(const Surface& src_surface, const Common::Rectangle<u32>& src_rect,
                       const Surface& dst_surface, const Common::Rectangle<u32>& dst_rect);
@@ -479,6 +497,12 @@ private:
     /// Update surface's texture for given region when necessary
     void ValidateSurface(const Surface& surface, PAddr addr, u32 size);
 
+    /// Records the memory hash the surface's texture was loaded from, 0 once it diverges
+    void SetTextureHash(const Surface& surface, u64 hash);
+
+    /// Copies the texture of another surface loaded from the same data, if there is one
+    bool CopyUploadedTexture(const Surface& surface, u64 hash);
+
     /// Create a new surface
     Surface CreateSurface(const SurfaceParams& params);
 
@@ -507,5 +531,9 @@ private:
     GLint d24s8_abgr_viewport_u_id;
 
     std::unordered_map<TextureCubeConfig, CachedTextureCube> texture_cube_cache;
+
+    /// A registered surface for each texture_hash in use
+    std::unordered_map<u64, Surface> uploaded_textures;
+    UploadStats upload_stats;
 };
 } // namespace OpenGL
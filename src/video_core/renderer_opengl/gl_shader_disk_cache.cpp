@@ -0,0 +1,164 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/loader/loader.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+
+namespace OpenGL {
+
+// On disk, raw entries hold the size of the configuration, the configuration and the GLSL code.
+// Program binary entries hold the binary format followed by the binary. The key hash is the hash
+// of the configuration or of the GLSL code, respectively.
+
+class ShaderDiskCache::Reader : public LinearDiskCacheReader<ShaderDiskCacheKey, u8> {
+public:
+    explicit Reader(std::unordered_map<u64, ProgramBinary>& program_binaries)
+        : program_binaries(program_binaries) {}
+
+    void Read(const ShaderDiskCacheKey& key, const u8* value, u32 value_size) override {
+        if (key.type == ShaderDiskCacheType::ProgramBinary) {
+            if (value_size < sizeof(GLenum))
+                return;
+
+            ProgramBinary program_binary;
+            std::memcpy(&program_binary.format, value, sizeof(GLenum));
+            program_binary.binary.assign(value + sizeof(GLenum), value + value_size);
+            program_binaries[key.hash] = std::move(program_binary);
+            return;
+        }
+
+        u32 config_size;
+        if (value_size < sizeof(config_size))
+            return;
+        std::memcpy(&config_size, value, sizeof(config_size));
+        if (value_size - sizeof(config_size) < config_size)
+            return;
+
+        const u8* config = value + sizeof(config_size);
+        const char* code = reinterpret_cast<const char*>(config + config_size);
+        const char* code_end = reinterpret_cast<const char*>(value + value_size);
+        raws.push_back({key.type, std::vector<u8>(config, config + config_size),
+                        std::string(code, code_end)});
+    }
+
+    std::vector<ShaderDiskCacheRaw> raws;
+
+private:
+    std::unordered_map<u64, ProgramBinary>& program_binaries;
+};
+
+ShaderDiskCache::ShaderDiskCache(bool separable) : separable(separable) {}
+
+ShaderDiskCache::~ShaderDiskCache() {
+    if (is_open)
+        file.Close();
+}
+
+std::vector<ShaderDiskCacheRaw> ShaderDiskCache::Load() {
+    u64 program_id;
+    if (Core::System::GetInstance().GetAppLoader().ReadProgramId(program_id) !=
+        Loader::ResultStatus::Success) {
+        LOG_ERROR(Render_OpenGL, "Unable to read the program ID, disk shader cache disabled");
+        return {};
+    }
+
+    const std::string dir = FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "shader" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Render_OpenGL, "Unable to create the disk shader cache directory {}", dir);
+        return {};
+    }
+
+    // Separable and conventional programs are generated differently, so they are kept apart
+    const std::string path =
+        fmt::format("{}{:016X}{}.bin", dir, program_id, separable ? "_separable" : "");
+
+    if (separable && GLAD_GL_ARB_get_program_binary) {
+        GLint num_formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+        binary_supported = num_formats > 0;
+    }
+
+    Reader reader(program_binaries);
+    const u32 num_entries = file.OpenAndRead(path.c_str(), reader);
+    is_open = true;
+
+    LOG_INFO(Render_OpenGL, "Loaded {} shaders and {} program binaries from {}",
+             reader.raws.size(), program_binaries.size(), path);
+    if (num_entries != reader.raws.size() + program_binaries.size()) {
+        LOG_WARNING(Render_OpenGL, "Skipped {} invalid or duplicate disk shader cache entries",
+                    num_entries - reader.raws.size() - program_binaries.size());
+    }
+    return std::move(reader.raws);
+}
+
+void ShaderDiskCache::SaveRaw(ShaderDiskCacheType type, const void* config,
+                              std::size_t config_size, const std::string& code) {
+    if (!is_open)
+        return;
+
+    const u32 size = static_cast<u32>(config_size);
+    std::vector<u8> value(sizeof(size) + config_size + code.size());
+    std::memcpy(value.data(), &size, sizeof(size));
+    std::memcpy(value.data() + sizeof(size), config, config_size);
+    std::memcpy(value.data() + sizeof(size) + config_size, code.data(), code.size());
+    Append(type, Common::ComputeHash64(config, config_size), value);
+}
+
+bool ShaderDiskCache::LoadProgramBinary(OGLProgram& program, const std::string& code) {
+    if (!binary_supported)
+        return false;
+
+    const auto iter = program_binaries.find(Common::ComputeHash64(code.data(), code.size()));
+    if (iter == program_binaries.end())
+        return false;
+
+    const ProgramBinary& program_binary = iter->second;
+    program.handle = glCreateProgram();
+    glProgramParameteri(program.handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glProgramBinary(program.handle, program_binary.format, program_binary.binary.data(),
+                    static_cast<GLsizei>(program_binary.binary.size()));
+
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program.handle, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE) {
+        // This happens after driver updates, the program is compiled again and a new binary saved
+        LOG_WARNING(Render_OpenGL, "Driver rejected a cached program binary");
+        program.Release();
+        program_binaries.erase(iter);
+        return false;
+    }
+    return true;
+}
+
+void ShaderDiskCache::SaveProgramBinary(const OGLProgram& program, const std::string& code) {
+    if (!is_open || !binary_supported)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program.handle, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    GLenum format;
+    std::vector<u8> value(sizeof(format) + length);
+    glGetProgramBinary(program.handle, length, nullptr, &format, value.data() + sizeof(format));
+    std::memcpy(value.data(), &format, sizeof(format));
+    Append(ShaderDiskCacheType::ProgramBinary, Common::ComputeHash64(code.data(), code.size()),
+           value);
+}
+
+void ShaderDiskCache::Append(ShaderDiskCacheType type, u64 hash, const std::vector<u8>& value) {
+    file.Append({type, 0, hash}, value.data(), static_cast<u32>(value.size()));
+    file.Sync();
+}
+
+} // namespace OpenGL
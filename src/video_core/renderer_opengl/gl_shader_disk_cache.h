@@ -0,0 +1,91 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/linear_disk_cache.h"
+
+namespace OpenGL {
+
+class OGLProgram;
+
+enum class ShaderDiskCacheType : u32 {
+    VertexShader,
+    GeometryShader,
+    FixedGeometryShader,
+    FragmentShader,
+    ProgramBinary,
+};
+
+struct ShaderDiskCacheKey {
+    ShaderDiskCacheType type;
+    u32 reserved;
+    u64 hash;
+};
+
+/// GLSL code generated for a shader configuration, as stored in the disk cache
+struct ShaderDiskCacheRaw {
+    ShaderDiskCacheType type;
+    std::vector<u8> config;
+    std::string code;
+};
+
+/**
+ * Per-title cache of the generated shaders on disk. It stores the raw shader configurations
+ * together with their GLSL code, so that they can be built at boot instead of on first use, and
+ * the program binaries of separable shader stages when the driver supports retrieving them.
+ */
+class ShaderDiskCache : NonCopyable {
+public:
+    explicit ShaderDiskCache(bool separable);
+    ~ShaderDiskCache();
+
+    /**
+     * Opens the cache file of the running title, keeping it open for appending new entries.
+     * @returns the raw shaders stored in the file
+     */
+    std::vector<ShaderDiskCacheRaw> Load();
+
+    /// Stores the GLSL code generated for a shader configuration
+    void SaveRaw(ShaderDiskCacheType type, const void* config, std::size_t config_size,
+                 const std::string& code);
+
+    template <typename KeyConfigType>
+    void SaveRaw(ShaderDiskCacheType type, const KeyConfigType& config, const std::string& code) {
+        SaveRaw(type, &config.state, sizeof(config.state), code);
+    }
+
+    /**
+     * Creates a separable program from the binary stored for the given GLSL code.
+     * @returns false if there is no binary or the driver rejected it
+     */
+    bool LoadProgramBinary(OGLProgram& program, const std::string& code);
+
+    /// Retrieves the binary of a linked separable program and stores it for the given GLSL code
+    void SaveProgramBinary(const OGLProgram& program, const std::string& code);
+
+private:
+    struct ProgramBinary {
+        GLenum format;
+        std::vector<u8> binary;
+    };
+
+    class Reader;
+
+    void Append(ShaderDiskCacheType type, u64 hash, const std::vector<u8>& value);
+
+    bool separable;
+    bool is_open = false;
+    bool binary_supported = false;
+    LinearDiskCache<ShaderDiskCacheKey, u8> file;
+    std::unordered_map<u64, ProgramBinary> program_binaries;
+};
+
+} // namespace OpenGL
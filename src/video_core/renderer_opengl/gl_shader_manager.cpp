@@ -3,9 +3,20 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
 #include <boost/variant.hpp>
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/frontend/emu_window.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
 
 namespace OpenGL {
@@ -45,11 +56,8 @@ static void SetShaderImageBinding(GLuint shader, const char* name, GLuint bindin
     }
 }
 
-static void SetShaderSamplerBindings(GLuint shader) {
-    OpenGLState cur_state = OpenGLState::GetCurState();
-    GLuint old_program = std::exchange(cur_state.draw.shader_program, shader);
-    cur_state.Apply();
-
+/// Sets the sampler and image uniforms of a program, which must be the one in use
+static void SetShaderSamplerUniforms(GLuint shader) {
     // Set the texture samplers to correspond to different texture units
     SetShaderSamplerBinding(shader, "tex0", TextureUnits::PicaTexture(0));
     SetShaderSamplerBinding(shader, "tex1", TextureUnits::PicaTexture(1));
@@ -67,6 +75,14 @@ static void SetShaderSamplerBindings(GLuint shader) {
     SetShaderImageBinding(shader, "shadow_texture_ny", ImageUnits::ShadowTextureNY);
     SetShaderImageBinding(shader, "shadow_texture_pz", ImageUnits::ShadowTexturePZ);
     SetShaderImageBinding(shader, "shadow_texture_nz", ImageUnits::ShadowTextureNZ);
+}
+
+static void SetShaderSamplerBindings(GLuint shader) {
+    OpenGLState cur_state = OpenGLState::GetCurState();
+    GLuint old_program = std::exchange(cur_state.draw.shader_program, shader);
+    cur_state.Apply();
+
+    SetShaderSamplerUniforms(shader);
 
     cur_state.draw.shader_program = old_program;
     cur_state.Apply();
@@ -89,11 +105,13 @@ void PicaUniformsData::SetFromRegs(const Pica::ShaderRegs& regs,
 
 /**
  * An object representing a shader program staging. It can be either a shader object or a program
- * object, depending on whether separable program is used.
+ * object, depending on whether separable program is used. Program objects are loaded from and
+ * saved to the disk cache as binaries if one is given.
  */
 class OGLShaderStage {
 public:
-    explicit OGLShaderStage(bool separable) {
+    explicit OGLShaderStage(bool separable, ShaderDiskCache* disk_cache = nullptr)
+        : disk_cache(disk_cache) {
         if (separable) {
             shader_or_program = OGLProgram();
         } else {
@@ -101,14 +119,19 @@ public:
         }
     }
 
-    void Create(const char* source, GLenum type) {
+    void Create(const std::string& source, GLenum type) {
         if (shader_or_program.which() == 0) {
-            boost::get<OGLShader>(shader_or_program).Create(source, type);
+            boost::get<OGLShader>(shader_or_program).Create(source.c_str(), type);
         } else {
-            OGLShader shader;
-            shader.Create(source, type);
             OGLProgram& program = boost::get<OGLProgram>(shader_or_program);
-            program.Create(true, {shader.handle});
+            if (!disk_cache || !disk_cache->LoadProgramBinary(program, source)) {
+                OGLShader shader;
+                shader.Create(source.c_str(), type);
+                program.Create(true, {shader.handle});
+                if (disk_cache)
+                    disk_cache->SaveProgramBinary(program, source);
+            }
+            // Uniform values are not part of the program binary
             SetShaderUniformBlockBindings(program.handle);
             SetShaderSamplerBindings(program.handle);
         }
@@ -124,12 +147,13 @@ public:
 
 private:
     boost::variant<OGLShader, OGLProgram> shader_or_program;
+    ShaderDiskCache* disk_cache;
 };
 
 class TrivialVertexShader {
 public:
     explicit TrivialVertexShader(bool separable) : program(separable) {
-        program.Create(GenerateTrivialVertexShader(separable).c_str(), GL_VERTEX_SHADER);
+        program.Create(GenerateTrivialVertexShader(separable), GL_VERTEX_SHADER);
     }
     GLuint Get() const {
         return program.GetHandle();
@@ -139,22 +163,52 @@ private:
     OGLShaderStage program;
 };
 
+/// Rebuilds a shader configuration stored in the disk cache, returns false on size mismatch
+template <typename KeyConfigType>
+static bool LoadConfig(KeyConfigType& config, const std::vector<u8>& data) {
+    if (data.size() != sizeof(config.state))
+        return false;
+    std::memcpy(&config.state, data.data(), sizeof(config.state));
+    return true;
+}
+
 template <typename KeyConfigType, std::string (*CodeGenerator)(const KeyConfigType&, bool),
-          GLenum ShaderType>
+          GLenum ShaderType, ShaderDiskCacheType DiskCacheType>
 class ShaderCache {
 public:
-    explicit ShaderCache(bool separable) : separable(separable) {}
+    ShaderCache(bool separable, ShaderDiskCache& disk_cache)
+        : separable(separable), disk_cache(disk_cache) {}
     GLuint Get(const KeyConfigType& config) {
-        auto [iter, new_shader] = shaders.emplace(config, OGLShaderStage{separable});
+        auto [iter, new_shader] = shaders.emplace(config, OGLShaderStage{separable, &disk_cache});
         OGLShaderStage& cached_shader = iter->second;
         if (new_shader) {
-            cached_shader.Create(CodeGenerator(config, separable).c_str(), ShaderType);
+            const std::string code = CodeGenerator(config, separable);
+            cached_shader.Create(code, ShaderType);
+            disk_cache.SaveRaw(DiskCacheType, config, code);
         }
         return cached_shader.GetHandle();
     }
 
+    /// Returns the shader built for a configuration, or 0 if there is none yet
+    GLuint Find(const KeyConfigType& config) const {
+        auto iter = shaders.find(config);
+        return iter != shaders.end() ? iter->second.GetHandle() : 0;
+    }
+
+    /// Builds a shader loaded from the disk cache without generating its code
+    void Inject(const std::vector<u8>& config_data, const std::string& code) {
+        KeyConfigType config;
+        if (!LoadConfig(config, config_data))
+            return;
+        auto [iter, new_shader] = shaders.emplace(config, OGLShaderStage{separable, &disk_cache});
+        if (new_shader) {
+            iter->second.Create(code, ShaderType);
+        }
+    }
+
 private:
     bool separable;
+    ShaderDiskCache& disk_cache;
     std::unordered_map<KeyConfigType, OGLShaderStage> shaders;
 };
 
@@ -166,10 +220,11 @@ private:
 template <typename KeyConfigType,
           std::optional<std::string> (*CodeGenerator)(const Pica::Shader::ShaderSetup&,
                                                       const KeyConfigType&, bool),
-          GLenum ShaderType>
+          GLenum ShaderType, ShaderDiskCacheType DiskCacheType>
 class ShaderDoubleCache {
 public:
-    explicit ShaderDoubleCache(bool separable) : separable(separable) {}
+    ShaderDoubleCache(bool separable, ShaderDiskCache& disk_cache)
+        : separable(separable), disk_cache(disk_cache) {}
     GLuint Get(const KeyConfigType& key, const Pica::Shader::ShaderSetup& setup) {
         auto map_it = shader_map.find(key);
         if (map_it == shader_map.end()) {
@@ -180,11 +235,8 @@ public:
             }
 
             std::string& program = *program_opt;
-            auto [iter, new_shader] = shader_cache.emplace(program, OGLShaderStage{separable});
-            OGLShaderStage& cached_shader = iter->second;
-            if (new_shader) {
-                cached_shader.Create(program.c_str(), ShaderType);
-            }
+            disk_cache.SaveRaw(DiskCacheType, key, program);
+            OGLShaderStage& cached_shader = GetStage(program);
             shader_map[key] = &cached_shader;
             return cached_shader.GetHandle();
         }
@@ -196,31 +248,203 @@ public:
         return map_it->second->GetHandle();
     }
 
+    /// Builds a shader loaded from the disk cache without generating its code
+    void Inject(const std::vector<u8>& config_data, const std::string& code) {
+        KeyConfigType key;
+        if (!LoadConfig(key, config_data))
+            return;
+        shader_map[key] = &GetStage(code);
+    }
+
 private:
+    OGLShaderStage& GetStage(const std::string& program) {
+        auto [iter, new_shader] =
+            shader_cache.emplace(program, OGLShaderStage{separable, &disk_cache});
+        OGLShaderStage& cached_shader = iter->second;
+        if (new_shader) {
+            cached_shader.Create(program, ShaderType);
+        }
+        return cached_shader;
+    }
+
     bool separable;
+    ShaderDiskCache& disk_cache;
     std::unordered_map<KeyConfigType, OGLShaderStage*> shader_map;
     std::unordered_map<std::string, OGLShaderStage> shader_cache;
 };
 
 using ProgrammableVertexShaders =
-    ShaderDoubleCache<PicaVSConfig, &GenerateVertexShader, GL_VERTEX_SHADER>;
+    ShaderDoubleCache<PicaVSConfig, &GenerateVertexShader, GL_VERTEX_SHADER,
+                      ShaderDiskCacheType::VertexShader>;
 
 using ProgrammableGeometryShaders =
-    ShaderDoubleCache<PicaGSConfig, &GenerateGeometryShader, GL_GEOMETRY_SHADER>;
+    ShaderDoubleCache<PicaGSConfig, &GenerateGeometryShader, GL_GEOMETRY_SHADER,
+                      ShaderDiskCacheType::GeometryShader>;
 
 using FixedGeometryShaders =
-    ShaderCache<PicaFixedGSConfig, &GenerateFixedGeometryShader, GL_GEOMETRY_SHADER>;
+    ShaderCache<PicaFixedGSConfig, &GenerateFixedGeometryShader, GL_GEOMETRY_SHADER,
+                ShaderDiskCacheType::FixedGeometryShader>;
 
-using FragmentShaders = ShaderCache<PicaFSConfig, &GenerateFragmentShader, GL_FRAGMENT_SHADER>;
+using FragmentShaders = ShaderCache<PicaFSConfig, &GenerateFragmentShader, GL_FRAGMENT_SHADER,
+                                    ShaderDiskCacheType::FragmentShader>;
+
+MICROPROFILE_DEFINE(OpenGL_AsyncShader, "OpenGL", "Async Shader Build", MP_RGB(100, 100, 255));
+
+/**
+ * Builds fragment shaders on a worker thread owning a context shared with the render thread, so
+ * that new configurations don't stall rendering. Only separable programs are built this way, as
+ * conventional programs are linked together with the other stages on the render thread anyway.
+ */
+class AsyncFragmentShaders {
+public:
+    AsyncFragmentShaders(std::unique_ptr<GraphicsContext> context, ShaderDiskCache& disk_cache)
+        : context(std::move(context)), disk_cache(disk_cache),
+          worker(&AsyncFragmentShaders::WorkerLoop, this) {}
+
+    ~AsyncFragmentShaders() {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+        }
+        queue_changed.notify_one();
+        worker.join();
+    }
+
+    /**
+     * Returns the program built for a configuration. Unknown configurations are queued for the
+     * worker thread.
+     * @returns the program handle, or 0 if the program is still being built
+     */
+    GLuint Get(const PicaFSConfig& config) {
+        CollectFinished();
+
+        auto iter = programs.find(config);
+        if (iter != programs.end())
+            return iter->second.handle;
+
+        auto [pending_iter, new_config] = pending.emplace(config, 0);
+        if (new_config) {
+            std::lock_guard lock{mutex};
+            queue.push_back(config);
+            queue_changed.notify_one();
+        }
+        ++pending_iter->second;
+        ++total_skipped_draws;
+        return 0;
+    }
+
+private:
+    struct BuiltShader {
+        PicaFSConfig config;
+        std::string code;
+        OGLProgram program;
+    };
+
+    /// Takes ownership of the programs finished by the worker, on the render thread
+    void CollectFinished() {
+        std::vector<BuiltShader> built;
+        {
+            std::lock_guard lock{mutex};
+            if (finished.empty())
+                return;
+            built.swap(finished);
+        }
+
+        for (BuiltShader& shader : built) {
+            auto pending_iter = pending.find(shader.config);
+            LOG_DEBUG(Render_OpenGL, "Fragment shader built in the background, skipped {} draws",
+                      pending_iter->second);
+            pending.erase(pending_iter);
+
+            disk_cache.SaveRaw(ShaderDiskCacheType::FragmentShader, shader.config, shader.code);
+            disk_cache.SaveProgramBinary(shader.program, shader.code);
+            programs.emplace(shader.config, std::move(shader.program));
+        }
+        LOG_DEBUG(Render_OpenGL, "{} draws skipped waiting for fragment shaders so far",
+                  total_skipped_draws);
+    }
+
+    void WorkerLoop() {
+        Common::SetCurrentThreadName("ShaderWorker");
+        MicroProfileOnThreadCreate("ShaderWorker");
+        context->MakeCurrent();
+
+        std::unique_lock lock{mutex};
+        while (true) {
+            queue_changed.wait(lock, [this] { return stop || !queue.empty(); });
+            if (stop)
+                break;
+            const PicaFSConfig config = queue.front();
+            queue.pop_front();
+            lock.unlock();
+
+            BuiltShader shader{config, GenerateFragmentShader(config, true), {}};
+            Build(shader);
+
+            lock.lock();
+            finished.push_back(std::move(shader));
+        }
+        lock.unlock();
+
+        context->DoneCurrent();
+        MicroProfileOnThreadExit();
+    }
+
+    static void Build(BuiltShader& shader) {
+        MICROPROFILE_SCOPE(OpenGL_AsyncShader);
+        OGLShader stage;
+        stage.Create(shader.code.c_str(), GL_FRAGMENT_SHADER);
+        shader.program.Create(true, {stage.handle});
+        SetShaderUniformBlockBindings(shader.program.handle);
+
+        // OpenGLState tracks the context of the render thread, so it's bypassed here
+        glUseProgram(shader.program.handle);
+        SetShaderSamplerUniforms(shader.program.handle);
+        glUseProgram(0);
+
+        // The program must be complete before the render thread binds it on its own context
+        glFinish();
+    }
+
+    std::unique_ptr<GraphicsContext> context;
+    ShaderDiskCache& disk_cache;
+
+    // Only accessed by the render thread
+    std::unordered_map<PicaFSConfig, OGLProgram> programs;
+    std::unordered_map<PicaFSConfig, std::size_t> pending; ///< Skipped draws for each config
+    std::size_t total_skipped_draws = 0;
+
+    std::mutex mutex;
+    std::condition_variable queue_changed;
+    std::deque<PicaFSConfig> queue;
+    std::vector<BuiltShader> finished;
+    bool stop = false;
+
+    std::thread worker;
+};
 
 class ShaderProgramManager::Impl {
 public:
-    explicit Impl(bool separable, bool is_amd)
-        : is_amd(is_amd), separable(separable), programmable_vertex_shaders(separable),
-          trivial_vertex_shader(separable), programmable_geometry_shaders(separable),
-          fixed_geometry_shaders(separable), fragment_shaders(separable) {
+    explicit Impl(bool separable, bool is_amd, EmuWindow& emu_window)
+        : disk_cache(separable), is_amd(is_amd), separable(separable),
+          programmable_vertex_shaders(separable, disk_cache), trivial_vertex_shader(separable),
+          programmable_geometry_shaders(separable, disk_cache),
+          fixed_geometry_shaders(separable, disk_cache), fragment_shaders(separable, disk_cache) {
         if (separable)
             pipeline.Create();
+
+        if (Settings::values.use_async_shader_compilation) {
+            if (!separable) {
+                LOG_WARNING(Render_OpenGL,
+                            "Asynchronous shader compilation requires separable programs");
+            } else if (auto context = emu_window.CreateSharedContext()) {
+                async_fragment_shaders =
+                    std::make_unique<AsyncFragmentShaders>(std::move(context), disk_cache);
+            } else {
+                LOG_WARNING(Render_OpenGL, "Asynchronous shader compilation requires the "
+                                           "frontend to support shared contexts");
+            }
+        }
     }
 
     struct ShaderTuple {
@@ -247,6 +471,8 @@ public:
         };
     };
 
+    ShaderDiskCache disk_cache;
+
     bool is_amd;
 
     ShaderTuple current;
@@ -258,14 +484,15 @@ public:
     FixedGeometryShaders fixed_geometry_shaders;
 
     FragmentShaders fragment_shaders;
+    std::unique_ptr<AsyncFragmentShaders> async_fragment_shaders;
 
     bool separable;
     std::unordered_map<ShaderTuple, OGLProgram, ShaderTuple::Hash> program_cache;
     OGLPipeline pipeline;
 };
 
-ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd)
-    : impl(std::make_unique<Impl>(separable, is_amd)) {}
+ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd, EmuWindow& emu_window)
+    : impl(std::make_unique<Impl>(separable, is_amd, emu_window)) {}
 
 ShaderProgramManager::~ShaderProgramManager() = default;
 
@@ -299,8 +526,61 @@ void ShaderProgramManager::UseTrivialGeometryShader() {
     impl->current.gs = 0;
 }
 
-void ShaderProgramManager::UseFragmentShader(const PicaFSConfig& config) {
-    impl->current.fs = impl->fragment_shaders.Get(config);
+bool ShaderProgramManager::UseFragmentShader(const PicaFSConfig& config) {
+    if (!impl->async_fragment_shaders) {
+        impl->current.fs = impl->fragment_shaders.Get(config);
+        return true;
+    }
+
+    // Shaders loaded from the disk cache are built synchronously at boot
+    GLuint handle = impl->fragment_shaders.Find(config);
+    if (handle == 0)
+        handle = impl->async_fragment_shaders->Get(config);
+    if (handle == 0)
+        return false;
+    impl->current.fs = handle;
+    return true;
+}
+
+void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
+                                         const VideoCore::DiskResourceLoadCallback& callback) {
+    if (!Settings::values.use_disk_shader_cache)
+        return;
+
+    if (callback)
+        callback(VideoCore::LoadCallbackStage::Prepare, 0, 0);
+
+    const std::vector<ShaderDiskCacheRaw> raws = impl->disk_cache.Load();
+    for (std::size_t i = 0; i < raws.size(); ++i) {
+        if (stop_loading)
+            return;
+
+        const ShaderDiskCacheRaw& raw = raws[i];
+        switch (raw.type) {
+        case ShaderDiskCacheType::VertexShader:
+            impl->programmable_vertex_shaders.Inject(raw.config, raw.code);
+            break;
+        case ShaderDiskCacheType::GeometryShader:
+            impl->programmable_geometry_shaders.Inject(raw.config, raw.code);
+            break;
+        case ShaderDiskCacheType::FixedGeometryShader:
+            impl->fixed_geometry_shaders.Inject(raw.config, raw.code);
+            break;
+        case ShaderDiskCacheType::FragmentShader:
+            impl->fragment_shaders.Inject(raw.config, raw.code);
+            break;
+        default:
+            LOG_ERROR(Render_OpenGL, "Unknown disk shader cache entry type {}",
+                      static_cast<u32>(raw.type));
+            break;
+        }
+
+        if (callback)
+            callback(VideoCore::LoadCallbackStage::Build, i + 1, raws.size());
+    }
+
+    if (callback)
+        callback(VideoCore::LoadCallbackStage::Complete, 0, 0);
 }
 
 void ShaderProgramManager::ApplyTo(OpenGLState& state) {
@@ -4,14 +4,18 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <glad/glad.h>
+#include "video_core/rasterizer_interface.h"
 #include "video_core/regs_lighting.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/pica_to_gl.h"
 
+class EmuWindow;
+
 namespace OpenGL {
 
 enum class UniformBindings : GLuint { Common, VS, GS };
@@ -103,7 +107,7 @@ static_assert(sizeof(GSUniformData) < 16384,
 /// A class that manage different shader stages and configures them with given config data.
 class ShaderProgramManager {
 public:
-    ShaderProgramManager(bool separable, bool is_amd);
+    ShaderProgramManager(bool separable, bool is_amd, EmuWindow& emu_window);
     ~ShaderProgramManager();
 
     bool UseProgrammableVertexShader(const PicaVSConfig& config,
@@ -118,7 +122,16 @@ public:
 
     void UseTrivialGeometryShader();
 
-    void UseFragmentShader(const PicaFSConfig& config);
+    /**
+     * Selects the fragment shader for a configuration.
+     * @returns false if the shader is still being built in the background, in which case the
+     * draw should be skipped
+     */
+    bool UseFragmentShader(const PicaFSConfig& config);
+
+    /// Opens the disk shader cache of the running title and builds all shaders stored in it
+    void LoadDiskCache(const std::atomic_bool& stop_loading,
+                       const VideoCore::DiskResourceLoadCallback& callback);
 
     void ApplyTo(OpenGLState& state);
 
@@ -0,0 +1,124 @@
+// Copyright 2019 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <unordered_map>
+#include <boost/container/small_vector.hpp>
+#include "common/assert.h"
+#include "common/common_types.h"
+
+namespace OpenGL {
+
+/**
+ * Page-granular index of address ranges, used by the rasterizer cache to find the surfaces
+ * overlapping a region. Every value is stored in a small vector for each page its range touches,
+ * so overlap queries only look at the pages they cover and never allocate.
+ */
+template <typename T>
+class SurfacePageIndex {
+public:
+    /// The index uses 64 KiB pages, so that a framebuffer only spans a handful of them
+    static constexpr u32 PAGE_BITS = 16;
+
+    /// Adds a value covering the address range [addr, end). Empty ranges are not indexed.
+    void Insert(const T& value, PAddr addr, PAddr end) {
+        if (addr >= end)
+            return;
+        for (u32 page = addr >> PAGE_BITS; page <= LastPage(end); ++page) {
+            pages[page].push_back({value, addr, end});
+        }
+        ++num_values;
+    }
+
+    /// Removes a value previously added with the same address range
+    void Erase(const T& value, PAddr addr, PAddr end) {
+        if (addr >= end)
+            return;
+        for (u32 page = addr >> PAGE_BITS; page <= LastPage(end); ++page) {
+            auto page_it = pages.find(page);
+            ASSERT(page_it != pages.end());
+            auto& entries = page_it->second;
+            auto entry_it = std::find_if(entries.begin(), entries.end(), [&value](const Entry& e) {
+                return e.value == value;
+            });
+            ASSERT(entry_it != entries.end());
+
+            // The order of values within a page does not matter, so avoid shifting the tail
+            *entry_it = std::move(entries.back());
+            entries.pop_back();
+            if (entries.empty())
+                pages.erase(page_it);
+        }
+        --num_values;
+    }
+
+    bool IsEmpty() const {
+        return num_values == 0;
+    }
+
+    /// Returns a copy of any of the values in the index, which must not be empty
+    T Front() const {
+        ASSERT(!IsEmpty());
+        return pages.begin()->second.front().value;
+    }
+
+    /**
+     * Calls func once for every value whose range overlaps [addr, end). The index must not be
+     * modified by func.
+     */
+    template <typename Func>
+    void ForEachOverlapping(PAddr addr, PAddr end, Func&& func) const {
+        if (addr >= end)
+            return;
+
+        const u32 first_page = addr >> PAGE_BITS;
+        const u32 last_page = LastPage(end);
+
+        auto VisitPage = [&](u32 page, const Entries& entries) {
+            for (const Entry& entry : entries) {
+                // A value spanning several pages is reported from the first page that both its
+                // range and the query cover
+                if (page != std::max(first_page, entry.addr >> PAGE_BITS))
+                    continue;
+                if (entry.addr < end && entry.end > addr)
+                    func(entry.value);
+            }
+        };
+
+        // Large queries (e.g. flushing everything) walk the occupied pages instead of the range
+        if (last_page - first_page >= pages.size()) {
+            for (const auto& pair : pages) {
+                if (pair.first >= first_page && pair.first <= last_page)
+                    VisitPage(pair.first, pair.second);
+            }
+            return;
+        }
+
+        for (u32 page = first_page; page <= last_page; ++page) {
+            auto page_it = pages.find(page);
+            if (page_it != pages.end())
+                VisitPage(page, page_it->second);
+        }
+    }
+
+private:
+    struct Entry {
+        T value;
+        PAddr addr;
+        PAddr end;
+    };
+    using Entries = boost::container::small_vector<Entry, 4>;
+
+    static u32 LastPage(PAddr end) {
+        return (end - 1) >> PAGE_BITS;
+    }
+
+    std::unordered_map<u32, Entries> pages;
+    std::size_t num_values = 0;
+};
+
+} // namespace OpenGL
@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <functional>
 #include <type_traits>
+#include <vector>
 #include <nihstro/shader_bytecode.h>
 #include "common/assert.h"
 #include "common/common_funcs.h"
@@ -34,8 +35,15 @@ struct AttributeBuffer {
 /// Handler type for receiving vertex outputs from vertex shader or geometry shader
 using VertexHandler = std::function<void(const AttributeBuffer&)>;
 
-/// Handler type for signaling to invert the vertex order of the next triangle
-using WindingSetter = std::function<void()>;
+/// A primitive emitted by the geometry shader, waiting to be sent to the primitive assembler
+struct EmittedPrimitive {
+    std::array<AttributeBuffer, 3> vertices;
+    /// Whether the vertex order of this triangle should be inverted
+    bool winding;
+};
+
+/// Handler type for receiving a batch of primitives emitted by geometry shader
+using PrimitiveHandler = std::function<void(const std::vector<EmittedPrimitive>&)>;
 
 struct OutputVertex {
     Common::Vec4<float24> pos;
@@ -78,12 +86,10 @@ struct GSEmitter {
     bool winding;
     u32 output_mask;
 
-    // Function objects are hidden behind a raw pointer to make the structure standard layout type,
-    // for JIT to use offsetof to access other members.
-    struct Handlers {
-        VertexHandler vertex_handler;
-        WindingSetter winding_setter;
-    } * handlers;
+    // The output buffer is hidden behind a raw pointer to make the structure standard layout type,
+    // for JIT to use offsetof to access other members. Emitted primitives are appended to it and
+    // drained by the geometry pipeline after each batch of geometry shader invocations.
+    std::vector<EmittedPrimitive>* emitted_primitives;
 
     GSEmitter();
     ~GSEmitter();
@@ -166,7 +172,6 @@ struct UnitState {
  */
 struct GSUnitState : public UnitState {
     GSUnitState();
-    void SetVertexHandler(VertexHandler vertex_handler, WindingSetter winding_setter);
     void ConfigOutput(const ShaderRegs& config);
 
     GSEmitter emitter;
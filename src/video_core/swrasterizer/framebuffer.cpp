@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <vector>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
@@ -18,6 +19,42 @@
 
 namespace Pica::Rasterizer {
 
+/// Coarse depth bounds of one 8x8 tile of the depth buffer. While a tile is valid, every depth
+/// value stored in it is guaranteed to lie within [min, max].
+struct DepthTile {
+    u32 min;
+    u32 max;
+    bool valid;
+};
+
+/// Hierarchical depth buffer for the depth buffer that is currently being rendered to
+static struct {
+    PAddr addr = 0;
+    u32 size = 0;
+    u32 width = 0;
+    u32 height = 0;
+    FramebufferRegs::DepthFormat format{};
+    std::vector<DepthTile> tiles;
+} depth_bounds;
+
+/// Returns the index of the tile containing the given byte offset into the depth buffer
+static std::size_t DepthTileIndex(u32 offset, u32 bytes_per_pixel) {
+    // Framebuffers are stored as a sequence of 8x8 tiles, each of them contiguous in memory
+    return offset / (8 * 8 * bytes_per_pixel);
+}
+
+static void UpdateDepthBounds(u32 offset, u32 bytes_per_pixel, u32 value) {
+    const std::size_t index = DepthTileIndex(offset, bytes_per_pixel);
+    if (index >= depth_bounds.tiles.size())
+        return;
+
+    DepthTile& tile = depth_bounds.tiles[index];
+    if (tile.valid) {
+        tile.min = std::min(tile.min, value);
+        tile.max = std::max(tile.max, value);
+    }
+}
+
 void DrawPixel(int x, int y, const Common::Vec4<u8>& color) {
     const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
     const PAddr addr = framebuffer.GetColorBufferPhysicalAddress();
@@ -169,6 +206,9 @@ void SetDepth(int x, int y, u32 value) {
     u32 dst_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
     u8* dst_pixel = depth_buffer + dst_offset;
 
+    if (addr == depth_bounds.addr)
+        UpdateDepthBounds(dst_offset, bytes_per_pixel, value);
+
     switch (framebuffer.depth_format) {
     case FramebufferRegs::DepthFormat::D16:
         Color::EncodeD16(value, dst_pixel);
@@ -408,4 +448,176 @@ void DrawShadowMapPixel(int x, int y, u32 depth, u8 stencil) {
     }
 }
 
+static u32 DecodeDepth(FramebufferRegs::DepthFormat format, const u8* bytes) {
+    switch (format) {
+    case FramebufferRegs::DepthFormat::D16:
+        return Color::DecodeD16(bytes);
+    case FramebufferRegs::DepthFormat::D24:
+        return Color::DecodeD24(bytes);
+    case FramebufferRegs::DepthFormat::D24S8:
+        return Color::DecodeD24S8(bytes).x;
+    default:
+        UNREACHABLE();
+        return 0;
+    }
+}
+
+/// Recomputes the exact depth bounds of a tile from the depth buffer contents
+static void LoadDepthTile(std::size_t index) {
+    const u32 bytes_per_pixel = FramebufferRegs::BytesPerDepthPixel(depth_bounds.format);
+    const u8* tile_data = VideoCore::g_memory->GetPhysicalPointer(depth_bounds.addr) +
+                          index * 8 * 8 * bytes_per_pixel;
+
+    DepthTile& tile = depth_bounds.tiles[index];
+    tile.min = tile.max = DecodeDepth(depth_bounds.format, tile_data);
+    for (u32 i = 1; i < 8 * 8; ++i) {
+        const u32 depth = DecodeDepth(depth_bounds.format, tile_data + i * bytes_per_pixel);
+        tile.min = std::min(tile.min, depth);
+        tile.max = std::max(tile.max, depth);
+    }
+    tile.valid = true;
+}
+
+void ResetDepthBounds() {
+    if (depth_bounds.addr != 0) {
+        VideoCore::g_memory->RasterizerMarkRegionCached(depth_bounds.addr, depth_bounds.size,
+                                                        false);
+    }
+
+    depth_bounds.addr = 0;
+    depth_bounds.size = 0;
+    depth_bounds.tiles.clear();
+}
+
+void InvalidateDepthBounds(PAddr addr, u32 size) {
+    if (depth_bounds.addr == 0 || addr >= depth_bounds.addr + depth_bounds.size ||
+        addr + size <= depth_bounds.addr) {
+        return;
+    }
+
+    const u32 tile_size = 8 * 8 * FramebufferRegs::BytesPerDepthPixel(depth_bounds.format);
+    const PAddr end_addr = depth_bounds.addr + depth_bounds.size;
+    const u32 start = std::max(addr, depth_bounds.addr) - depth_bounds.addr;
+    const u32 end = std::min(addr + size, end_addr) - depth_bounds.addr;
+    for (u32 index = start / tile_size; index < (end + tile_size - 1) / tile_size; ++index) {
+        depth_bounds.tiles[index].valid = false;
+    }
+}
+
+bool PrepareEarlyDepthTest() {
+    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+    const auto& output_merger = g_state.regs.framebuffer.output_merger;
+
+    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
+    const u32 width = framebuffer.GetWidth();
+    const u32 height = framebuffer.GetHeight();
+    const auto format = framebuffer.depth_format.Value();
+
+    if (format != FramebufferRegs::DepthFormat::D16 &&
+        format != FramebufferRegs::DepthFormat::D24 &&
+        format != FramebufferRegs::DepthFormat::D24S8) {
+        ResetDepthBounds();
+        return false;
+    }
+
+    const u32 num_tiles = (width / 8) * ((height + 7) / 8);
+    const u32 size = num_tiles * 8 * 8 * FramebufferRegs::BytesPerDepthPixel(format);
+
+    // Color writes into the depth buffer would bypass the depth bounds
+    const PAddr color_addr = framebuffer.GetColorBufferPhysicalAddress();
+    const u32 color_size =
+        width * height *
+        GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(framebuffer.color_format.Value()));
+    if (color_addr < addr + size && color_addr + color_size > addr) {
+        ResetDepthBounds();
+        return false;
+    }
+
+    if (addr != depth_bounds.addr || width != depth_bounds.width ||
+        height != depth_bounds.height || format != depth_bounds.format) {
+        ResetDepthBounds();
+
+        if (size == 0 || width % 8 != 0 || !VideoCore::g_memory->IsValidPhysicalAddress(addr) ||
+            !VideoCore::g_memory->IsValidPhysicalAddress(addr + size - 1)) {
+            return false;
+        }
+
+        // Route CPU writes to the depth buffer through RasterizerInvalidateRegion so that the
+        // affected tiles get invalidated
+        VideoCore::g_memory->RasterizerMarkRegionCached(addr, size, true);
+
+        depth_bounds.addr = addr;
+        depth_bounds.size = size;
+        depth_bounds.width = width;
+        depth_bounds.height = height;
+        depth_bounds.format = format;
+        depth_bounds.tiles.assign(num_tiles, DepthTile{0, 0, false});
+    }
+
+    if (!output_merger.depth_test_enable ||
+        output_merger.fragment_operation_mode != FramebufferRegs::FragmentOperationMode::Default) {
+        return false;
+    }
+
+    // A depth test failure also triggers the stencil depth-fail action
+    if (output_merger.stencil_test.enable && format == FramebufferRegs::DepthFormat::D24S8)
+        return false;
+
+    return true;
+}
+
+/// Checks whether the depth test fails for all depth values in [z_min, z_max] against all
+/// reference values in [ref_min, ref_max]
+static bool DepthTestFailsForRange(FramebufferRegs::CompareFunc func, u32 z_min, u32 z_max,
+                                   u32 ref_min, u32 ref_max) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return true;
+    case FramebufferRegs::CompareFunc::Always:
+        return false;
+    case FramebufferRegs::CompareFunc::Equal:
+        return z_max < ref_min || z_min > ref_max;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return z_min == z_max && ref_min == ref_max && z_min == ref_min;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return z_min >= ref_max;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return z_min > ref_max;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return z_max <= ref_min;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return z_max < ref_min;
+    }
+
+    return false;
+}
+
+bool EarlyDepthTestFails(int x1, int y1, int x2, int y2, u32 z_min, u32 z_max) {
+    const auto func = g_state.regs.framebuffer.output_merger.depth_test_func.Value();
+    const u32 tiles_per_row = depth_bounds.width / 8;
+    const int fb_height = static_cast<int>(depth_bounds.height) - 1;
+
+    // Pixels outside of the framebuffer are not tracked
+    if (x1 < 0 || y1 < 0 || x2 >= static_cast<int>(depth_bounds.width) || y2 > fb_height)
+        return false;
+
+    // The framebuffer is laid out from bottom to top
+    const u32 first_row = static_cast<u32>(fb_height - y2) / 8;
+    const u32 last_row = static_cast<u32>(fb_height - y1) / 8;
+
+    for (u32 row = first_row; row <= last_row; ++row) {
+        for (u32 column = x1 / 8; column <= static_cast<u32>(x2) / 8; ++column) {
+            const std::size_t index = row * tiles_per_row + column;
+            if (!depth_bounds.tiles[index].valid)
+                LoadDepthTile(index);
+
+            const DepthTile& tile = depth_bounds.tiles[index];
+            if (!DepthTestFailsForRange(func, z_min, z_max, tile.min, tile.max))
+                return false;
+        }
+    }
+
+    return true;
+}
+
 } // namespace Pica::Rasterizer
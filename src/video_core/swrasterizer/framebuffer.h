@@ -28,4 +28,23 @@ u8 LogicOp(u8 src, u8 dest, FramebufferRegs::LogicOp op);
 
 void DrawShadowMapPixel(int x, int y, u32 depth, u8 stencil);
 
+/**
+ * Prepares the hierarchical depth buffer for the current framebuffer configuration.
+ * @returns true if depth tests may be resolved early against the coarse per-tile depth bounds,
+ *          i.e. if a failing depth test discards the fragment without any other side effects
+ */
+bool PrepareEarlyDepthTest();
+
+/**
+ * Checks whether the depth test fails for every pixel in the given screen rectangle (inclusive)
+ * for all depth values in [z_min, z_max]. Only valid if PrepareEarlyDepthTest returned true.
+ */
+bool EarlyDepthTestFails(int x1, int y1, int x2, int y2, u32 z_min, u32 z_max);
+
+/// Invalidates the coarse depth bounds of all tiles overlapping the given physical region
+void InvalidateDepthBounds(PAddr addr, u32 size);
+
+/// Drops the hierarchical depth buffer and releases the memory region it tracks
+void ResetDepthBounds();
+
 } // namespace Pica::Rasterizer
@@ -7,21 +7,137 @@
 
 namespace Pica {
 
-static float LookupLightingLut(const Pica::State::Lighting& lighting, std::size_t lut_index,
-                               u8 index, float delta) {
-    ASSERT_MSG(lut_index < lighting.luts.size(), "Out of range lut");
-    ASSERT_MSG(index < lighting.luts[lut_index].size(), "Out of range index");
+static LightingSetup lighting_setup;
+static bool lighting_regs_dirty = true;
+static std::array<bool, LightingRegs::NumLightingSampler> lighting_lut_dirty = [] {
+    std::array<bool, LightingRegs::NumLightingSampler> dirty;
+    dirty.fill(true);
+    return dirty;
+}();
+static bool lighting_lut_dirty_any = true;
+
+void MarkLightingRegsDirty() {
+    lighting_regs_dirty = true;
+}
 
-    const auto& lut = lighting.luts[lut_index][index];
+void MarkLightingLutDirty(std::size_t lut_index) {
+    if (lut_index >= lighting_lut_dirty.size())
+        return;
 
-    float lut_value = lut.ToFloat();
-    float lut_diff = lut.DiffToFloat();
+    lighting_lut_dirty[lut_index] = true;
+    lighting_lut_dirty_any = true;
+}
 
-    return lut_value + lut_diff * delta;
+static LightingSetup::LutLookup MakeLutLookup(const Pica::LightingRegs& lighting,
+                                              LightingRegs::LightingSampler sampler, bool disable,
+                                              bool disable_abs,
+                                              LightingRegs::LightingLutInput input,
+                                              LightingRegs::LightingScale scale) {
+    LightingSetup::LutLookup lookup;
+    lookup.enable =
+        !disable && LightingRegs::IsLightingSamplerSupported(lighting.config0.config, sampler);
+    lookup.abs = !disable_abs;
+    lookup.input = input;
+    lookup.scale = lighting.lut_scale.GetScale(scale);
+    return lookup;
+}
+
+static void SetupLightingRegs(const Pica::LightingRegs& lighting, LightingSetup& setup) {
+    using Sampler = LightingRegs::LightingSampler;
+
+    setup.num_lights = lighting.max_light_index + 1;
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const unsigned num = lighting.light_enable.GetNum(light_index);
+        const auto& light_config = lighting.light[num];
+        auto& light = setup.lights[light_index];
+
+        light.num = num;
+        light.position = {float16::FromRaw(light_config.x).ToFloat32(),
+                          float16::FromRaw(light_config.y).ToFloat32(),
+                          float16::FromRaw(light_config.z).ToFloat32()};
+        light.spot_direction =
+            Common::Vec3<s32>{light_config.spot_x.Value(), light_config.spot_y.Value(),
+                              light_config.spot_z.Value()}
+                .Cast<float>() /
+            2047.0f;
+        light.specular_0 = light_config.specular_0.ToVec3f();
+        light.specular_1 = light_config.specular_1.ToVec3f();
+        light.diffuse = light_config.diffuse.ToVec3f();
+        light.ambient = light_config.ambient.ToVec3f();
+        light.dist_atten_scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
+        light.dist_atten_bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+        light.directional = light_config.config.directional != 0;
+        light.two_sided_diffuse = light_config.config.two_sided_diffuse != 0;
+        light.geometric_factor_0 = light_config.config.geometric_factor_0 != 0;
+        light.geometric_factor_1 = light_config.config.geometric_factor_1 != 0;
+        light.dist_atten_enable = !lighting.IsDistAttenDisabled(num);
+        light.spot_atten_enable =
+            !lighting.IsSpotAttenDisabled(num) &&
+            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
+                                                     Sampler::SpotlightAttenuation);
+        light.shadow_enable = !lighting.IsShadowDisabled(num);
+    }
+
+    setup.d0 = MakeLutLookup(lighting, Sampler::Distribution0, lighting.config1.disable_lut_d0,
+                             lighting.abs_lut_input.disable_d0, lighting.lut_input.d0,
+                             lighting.lut_scale.d0);
+    setup.d1 = MakeLutLookup(lighting, Sampler::Distribution1, lighting.config1.disable_lut_d1,
+                             lighting.abs_lut_input.disable_d1, lighting.lut_input.d1,
+                             lighting.lut_scale.d1);
+    setup.rr = MakeLutLookup(lighting, Sampler::ReflectRed, lighting.config1.disable_lut_rr,
+                             lighting.abs_lut_input.disable_rr, lighting.lut_input.rr,
+                             lighting.lut_scale.rr);
+    setup.rg = MakeLutLookup(lighting, Sampler::ReflectGreen, lighting.config1.disable_lut_rg,
+                             lighting.abs_lut_input.disable_rg, lighting.lut_input.rg,
+                             lighting.lut_scale.rg);
+    setup.rb = MakeLutLookup(lighting, Sampler::ReflectBlue, lighting.config1.disable_lut_rb,
+                             lighting.abs_lut_input.disable_rb, lighting.lut_input.rb,
+                             lighting.lut_scale.rb);
+    setup.fr = MakeLutLookup(lighting, Sampler::Fresnel, lighting.config1.disable_lut_fr,
+                             lighting.abs_lut_input.disable_fr, lighting.lut_input.fr,
+                             lighting.lut_scale.fr);
+    // Spotlight attenuation is enabled per light, see LightingSetup::Light::spot_atten_enable
+    setup.sp = MakeLutLookup(lighting, Sampler::SpotlightAttenuation, false,
+                             lighting.abs_lut_input.disable_sp, lighting.lut_input.sp,
+                             lighting.lut_scale.sp);
+
+    setup.global_ambient = lighting.global_ambient.ToVec3f();
+}
+
+const LightingSetup& GetLightingSetup(const Pica::LightingRegs& lighting,
+                                      const Pica::State::Lighting& lighting_state) {
+    if (lighting_regs_dirty) {
+        SetupLightingRegs(lighting, lighting_setup);
+        lighting_regs_dirty = false;
+    }
+
+    if (lighting_lut_dirty_any) {
+        for (std::size_t index = 0; index < lighting_lut_dirty.size(); ++index) {
+            if (!lighting_lut_dirty[index])
+                continue;
+
+            std::transform(lighting_state.luts[index].begin(), lighting_state.luts[index].end(),
+                           lighting_setup.luts[index].begin(), [](const auto& entry) {
+                               return Common::MakeVec(entry.ToFloat(), entry.DiffToFloat());
+                           });
+            lighting_lut_dirty[index] = false;
+        }
+        lighting_lut_dirty_any = false;
+    }
+
+    return lighting_setup;
+}
+
+static float LookupLightingLut(const LightingSetup& setup, std::size_t lut_index, u8 index,
+                               float delta) {
+    ASSERT_MSG(lut_index < setup.luts.size(), "Out of range lut");
+
+    const auto& lut = setup.luts[lut_index][index];
+    return lut.x + lut.y * delta;
 }
 
 std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
+    const Pica::LightingRegs& lighting, const LightingSetup& setup,
     const Common::Quaternion<float>& normquat, const Common::Vec3<float>& view,
     const Common::Vec4<u8> (&texture_color)[4]) {
 
@@ -65,76 +181,72 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
     auto normal = Common::QuaternionRotate(normquat, surface_normal);
     auto tangent = Common::QuaternionRotate(normquat, surface_tangent);
 
+    // These only depend on the fragment, so compute them once for all lights
+    const Common::Vec3<float> norm_view = view.Normalized();
+    const float nv_dot = Common::Dot(normal, norm_view);
+
     Common::Vec4<float> diffuse_sum = {0.0f, 0.0f, 0.0f, 1.0f};
     Common::Vec4<float> specular_sum = {0.0f, 0.0f, 0.0f, 1.0f};
 
-    for (unsigned light_index = 0; light_index <= lighting.max_light_index; ++light_index) {
-        unsigned num = lighting.light_enable.GetNum(light_index);
-        const auto& light_config = lighting.light[num];
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const auto& light = setup.lights[light_index];
 
         Common::Vec3<float> refl_value = {};
-        Common::Vec3<float> position = {float16::FromRaw(light_config.x).ToFloat32(),
-                                        float16::FromRaw(light_config.y).ToFloat32(),
-                                        float16::FromRaw(light_config.z).ToFloat32()};
         Common::Vec3<float> light_vector;
 
-        if (light_config.config.directional)
-            light_vector = position;
+        if (light.directional)
+            light_vector = light.position;
         else
-            light_vector = position + view;
+            light_vector = light.position + view;
 
         light_vector.Normalize();
 
-        Common::Vec3<float> norm_view = view.Normalized();
         Common::Vec3<float> half_vector = norm_view + light_vector;
+        const Common::Vec3<float> norm_half_vector = half_vector.Normalized();
 
         float dist_atten = 1.0f;
-        if (!lighting.IsDistAttenDisabled(num)) {
-            auto distance = (-view - position).Length();
-            float scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
-            float bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+        if (light.dist_atten_enable) {
+            auto distance = (-view - light.position).Length();
             std::size_t lut =
-                static_cast<std::size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + num;
+                static_cast<std::size_t>(LightingRegs::LightingSampler::DistanceAttenuation) +
+                light.num;
 
-            float sample_loc = std::clamp(scale * distance + bias, 0.0f, 1.0f);
+            float sample_loc = std::clamp(
+                light.dist_atten_scale * distance + light.dist_atten_bias, 0.0f, 1.0f);
 
             u8 lutindex =
                 static_cast<u8>(std::clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
             float delta = sample_loc * 256 - lutindex;
-            dist_atten = LookupLightingLut(lighting_state, lut, lutindex, delta);
+            dist_atten = LookupLightingLut(setup, lut, lutindex, delta);
         }
 
-        auto GetLutValue = [&](LightingRegs::LightingLutInput input, bool abs,
-                               LightingRegs::LightingScale scale_enum,
+        auto GetLutValue = [&](const LightingSetup::LutLookup& lookup,
                                LightingRegs::LightingSampler sampler) {
             float result = 0.0f;
 
-            switch (input) {
+            switch (lookup.input) {
             case LightingRegs::LightingLutInput::NH:
-                result = Common::Dot(normal, half_vector.Normalized());
+                result = Common::Dot(normal, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::VH:
-                result = Common::Dot(norm_view, half_vector.Normalized());
+                result = Common::Dot(norm_view, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::NV:
-                result = Common::Dot(normal, norm_view);
+                result = nv_dot;
                 break;
 
             case LightingRegs::LightingLutInput::LN:
                 result = Common::Dot(light_vector, normal);
                 break;
 
-            case LightingRegs::LightingLutInput::SP: {
-                Common::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
-                                           light_config.spot_z.Value()};
-                result = Common::Dot(light_vector, spot_dir.Cast<float>() / 2047.0f);
+            case LightingRegs::LightingLutInput::SP:
+                result = Common::Dot(light_vector, light.spot_direction);
                 break;
-            }
+
             case LightingRegs::LightingLutInput::CP:
                 if (lighting.config0.config == LightingRegs::LightingConfig::Config7) {
-                    const Common::Vec3<float> norm_half_vector = half_vector.Normalized();
                     const Common::Vec3<float> half_vector_proj =
                         norm_half_vector - normal * Common::Dot(normal, norm_half_vector);
                     result = Common::Dot(half_vector_proj, tangent);
@@ -143,7 +255,8 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
                 }
                 break;
             default:
-                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}", static_cast<u32>(input));
+                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input {}",
+                             static_cast<u32>(lookup.input));
                 UNIMPLEMENTED();
                 result = 0.0f;
             }
@@ -151,8 +264,8 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
             u8 index;
             float delta;
 
-            if (abs) {
-                if (light_config.config.two_sided_diffuse)
+            if (lookup.abs) {
+                if (light.two_sided_diffuse)
                     result = std::abs(result);
                 else
                     result = std::max(result, 0.0f);
@@ -167,88 +280,58 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
                 index = static_cast<u8>(signed_index);
             }
 
-            float scale = lighting.lut_scale.GetScale(scale_enum);
-            return scale * LookupLightingLut(lighting_state, static_cast<std::size_t>(sampler),
-                                             index, delta);
+            return lookup.scale *
+                   LookupLightingLut(setup, static_cast<std::size_t>(sampler), index, delta);
         };
 
         // If enabled, compute spot light attenuation value
         float spot_atten = 1.0f;
-        if (!lighting.IsSpotAttenDisabled(num) &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::SpotlightAttenuation)) {
-            auto lut = LightingRegs::SpotlightAttenuationSampler(num);
-            spot_atten = GetLutValue(lighting.lut_input.sp, lighting.abs_lut_input.disable_sp == 0,
-                                     lighting.lut_scale.sp, lut);
+        if (light.spot_atten_enable) {
+            spot_atten =
+                GetLutValue(setup.sp, LightingRegs::SpotlightAttenuationSampler(light.num));
         }
 
         // Specular 0 component
         float d0_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d0 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution0)) {
-            d0_lut_value =
-                GetLutValue(lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
-                            lighting.lut_scale.d0, LightingRegs::LightingSampler::Distribution0);
+        if (setup.d0.enable) {
+            d0_lut_value = GetLutValue(setup.d0, LightingRegs::LightingSampler::Distribution0);
         }
 
-        Common::Vec3<float> specular_0 = d0_lut_value * light_config.specular_0.ToVec3f();
+        Common::Vec3<float> specular_0 = d0_lut_value * light.specular_0;
 
         // If enabled, lookup ReflectRed value, otherwise, 1.0 is used
-        if (lighting.config1.disable_lut_rr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectRed)) {
-            refl_value.x =
-                GetLutValue(lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
-                            lighting.lut_scale.rr, LightingRegs::LightingSampler::ReflectRed);
+        if (setup.rr.enable) {
+            refl_value.x = GetLutValue(setup.rr, LightingRegs::LightingSampler::ReflectRed);
         } else {
             refl_value.x = 1.0f;
         }
 
         // If enabled, lookup ReflectGreen value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rg == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectGreen)) {
-            refl_value.y =
-                GetLutValue(lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
-                            lighting.lut_scale.rg, LightingRegs::LightingSampler::ReflectGreen);
+        if (setup.rg.enable) {
+            refl_value.y = GetLutValue(setup.rg, LightingRegs::LightingSampler::ReflectGreen);
         } else {
             refl_value.y = refl_value.x;
         }
 
         // If enabled, lookup ReflectBlue value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rb == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectBlue)) {
-            refl_value.z =
-                GetLutValue(lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
-                            lighting.lut_scale.rb, LightingRegs::LightingSampler::ReflectBlue);
+        if (setup.rb.enable) {
+            refl_value.z = GetLutValue(setup.rb, LightingRegs::LightingSampler::ReflectBlue);
         } else {
             refl_value.z = refl_value.x;
         }
 
         // Specular 1 component
         float d1_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d1 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution1)) {
-            d1_lut_value =
-                GetLutValue(lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
-                            lighting.lut_scale.d1, LightingRegs::LightingSampler::Distribution1);
+        if (setup.d1.enable) {
+            d1_lut_value = GetLutValue(setup.d1, LightingRegs::LightingSampler::Distribution1);
         }
 
-        Common::Vec3<float> specular_1 =
-            d1_lut_value * refl_value * light_config.specular_1.ToVec3f();
+        Common::Vec3<float> specular_1 = d1_lut_value * refl_value * light.specular_1;
 
         // Fresnel
         // Note: only the last entry in the light slots applies the Fresnel factor
-        if (light_index == lighting.max_light_index && lighting.config1.disable_lut_fr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::Fresnel)) {
-
-            float lut_value =
-                GetLutValue(lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
-                            lighting.lut_scale.fr, LightingRegs::LightingSampler::Fresnel);
+        if (light_index == setup.num_lights - 1 && setup.fr.enable) {
+            float lut_value = GetLutValue(setup.fr, LightingRegs::LightingSampler::Fresnel);
 
             // Enabled for diffuse lighting alpha component
             if (lighting.config0.enable_primary_alpha) {
@@ -262,7 +345,7 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
         }
 
         auto dot_product = Common::Dot(light_vector, normal);
-        if (light_config.config.two_sided_diffuse)
+        if (light.two_sided_diffuse)
             dot_product = std::abs(dot_product);
         else
             dot_product = std::max(dot_product, 0.0f);
@@ -272,23 +355,21 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
             clamp_highlights = dot_product == 0.0f ? 0.0f : 1.0f;
         }
 
-        if (light_config.config.geometric_factor_0 || light_config.config.geometric_factor_1) {
+        if (light.geometric_factor_0 || light.geometric_factor_1) {
             float geo_factor = half_vector.Length2();
             geo_factor = geo_factor == 0.0f ? 0.0f : std::min(dot_product / geo_factor, 1.0f);
-            if (light_config.config.geometric_factor_0) {
+            if (light.geometric_factor_0) {
                 specular_0 *= geo_factor;
             }
-            if (light_config.config.geometric_factor_1) {
+            if (light.geometric_factor_1) {
                 specular_1 *= geo_factor;
             }
         }
 
-        auto diffuse =
-            (light_config.diffuse.ToVec3f() * dot_product + light_config.ambient.ToVec3f()) *
-            dist_atten * spot_atten;
+        auto diffuse = (light.diffuse * dot_product + light.ambient) * dist_atten * spot_atten;
         auto specular = (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
 
-        if (!lighting.IsShadowDisabled(num)) {
+        if (light.shadow_enable) {
             if (lighting.config0.shadow_primary) {
                 diffuse = diffuse * shadow.xyz();
             }
@@ -314,7 +395,7 @@ std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
         }
     }
 
-    diffuse_sum += Common::MakeVec(lighting.global_ambient.ToVec3f(), 0.0f);
+    diffuse_sum += Common::MakeVec(setup.global_ambient, 0.0f);
 
     auto diffuse = Common::MakeVec<float>(std::clamp(diffuse_sum.x, 0.0f, 1.0f) * 255,
                                           std::clamp(diffuse_sum.y, 0.0f, 1.0f) * 255,
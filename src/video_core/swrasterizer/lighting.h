@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include "common/quaternion.h"
 #include "common/vector_math.h"
@@ -11,8 +12,68 @@
 
 namespace Pica {
 
+/**
+ * Fragment lighting state converted into a form that is cheap to evaluate per fragment. It is
+ * rebuilt lazily from the lighting registers and LUTs whenever these were marked dirty.
+ */
+struct LightingSetup {
+    /// Per-light constants that do not depend on the fragment
+    struct Light {
+        unsigned num;
+        Common::Vec3<float> position;
+        Common::Vec3<float> spot_direction;
+        Common::Vec3<float> specular_0;
+        Common::Vec3<float> specular_1;
+        Common::Vec3<float> diffuse;
+        Common::Vec3<float> ambient;
+        float dist_atten_scale;
+        float dist_atten_bias;
+        bool directional;
+        bool two_sided_diffuse;
+        bool geometric_factor_0;
+        bool geometric_factor_1;
+        bool dist_atten_enable;
+        bool spot_atten_enable;
+        bool shadow_enable;
+    };
+
+    /// Configuration of a LUT lookup that is shared by all lights
+    struct LutLookup {
+        bool enable;
+        bool abs;
+        LightingRegs::LightingLutInput input;
+        float scale;
+    };
+
+    std::array<Light, 8> lights;
+    unsigned num_lights;
+
+    LutLookup d0;
+    LutLookup d1;
+    LutLookup rr;
+    LutLookup rg;
+    LutLookup rb;
+    LutLookup fr;
+    LutLookup sp;
+
+    Common::Vec3<float> global_ambient;
+
+    /// Lighting LUTs stored as (value, difference) pairs, ready for interpolation
+    std::array<std::array<Common::Vec2<float>, 256>, LightingRegs::NumLightingSampler> luts;
+};
+
+/// Marks the lighting registers as changed, causing the per-light constants to be rebuilt
+void MarkLightingRegsDirty();
+
+/// Marks the given lighting LUT as changed, causing it to be converted again
+void MarkLightingLutDirty(std::size_t lut_index);
+
+/// Returns the lighting setup for the given state, rebuilding all parts that were marked dirty
+const LightingSetup& GetLightingSetup(const Pica::LightingRegs& lighting,
+                                      const Pica::State::Lighting& lighting_state);
+
 std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
+    const Pica::LightingRegs& lighting, const LightingSetup& setup,
     const Common::Quaternion<float>& normquat, const Common::Vec3<float>& view,
     const Common::Vec4<u8> (&texture_color)[4]);
 
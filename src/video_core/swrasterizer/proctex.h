@@ -2,13 +2,56 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#pragma once
+
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/pica_state.h"
 
 namespace Pica::Rasterizer {
 
+/**
+ * Procedural texture state decoded into a form that is cheap to evaluate per fragment. It is
+ * rebuilt lazily from the proctex registers and LUTs whenever these were marked dirty.
+ */
+struct ProcTexSetup {
+    TexturingRegs::ProcTexClamp u_clamp;
+    TexturingRegs::ProcTexClamp v_clamp;
+    TexturingRegs::ProcTexShift u_shift;
+    TexturingRegs::ProcTexShift v_shift;
+    TexturingRegs::ProcTexCombiner color_combiner;
+    TexturingRegs::ProcTexCombiner alpha_combiner;
+    bool separate_alpha;
+
+    bool noise_enable;
+    float noise_freq_u;
+    float noise_freq_v;
+    float noise_phase_u;
+    float noise_phase_v;
+    s32 noise_amplitude_u;
+    s32 noise_amplitude_v;
+
+    TexturingRegs::ProcTexFilter filter;
+    u32 lut_offset;
+    u32 lut_width;
+
+    /// Value LUTs stored as (value, difference) pairs, ready for interpolation
+    std::array<Common::Vec2<float>, 128> noise_table;
+    std::array<Common::Vec2<float>, 128> color_map_table;
+    std::array<Common::Vec2<float>, 128> alpha_map_table;
+
+    std::array<Common::Vec4<float>, 256> color_table;
+    std::array<Common::Vec4<float>, 256> color_diff_table;
+};
+
+/// Marks the procedural texture registers or LUTs as changed
+void MarkProcTexDirty();
+
+/// Returns the procedural texture setup for the given state, rebuilding it if it was marked dirty
+const ProcTexSetup& GetProcTexSetup(const TexturingRegs& regs, const State::ProcTex& state);
+
 /// Generates procedural texture color for the given coordinates
-Common::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state);
+Common::Vec4<u8> ProcTex(float u, float v, const ProcTexSetup& setup);
 
 } // namespace Pica::Rasterizer
@@ -210,10 +210,39 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     int bias2 =
         IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
+    // Reject the whole triangle early if the hierarchical depth buffer shows it is occluded
+    const bool early_depth_test = PrepareEarlyDepthTest();
+    if (early_depth_test && max_x > min_x && max_y > min_y &&
+        regs.rasterizer.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::ZBuffering) {
+        unsigned num_bits =
+            FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
+        float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+        float depth_offset =
+            float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+        auto ToDepth = [&](const Vertex& v) {
+            float depth = std::clamp(v.screenpos[2].ToFloat32() * depth_scale + depth_offset,
+                                     0.0f, 1.0f);
+            return (u32)(depth * ((1 << num_bits) - 1));
+        };
+
+        // Widen the range by one unit to account for rounding in the interpolation
+        u32 z_min = std::min({ToDepth(v0), ToDepth(v1), ToDepth(v2)});
+        u32 z_max = std::max({ToDepth(v0), ToDepth(v1), ToDepth(v2)});
+        z_min = z_min > 0 ? z_min - 1 : 0;
+        z_max = z_max + 1;
+
+        if (EarlyDepthTestFails(min_x >> 4, min_y >> 4, (max_x >> 4) - 1, (max_y >> 4) - 1, z_min,
+                                z_max)) {
+            return;
+        }
+    }
+
     auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
     auto textures = regs.texturing.GetTextures();
     auto tev_stages = regs.texturing.GetTevStages();
+    const auto& lighting_setup = GetLightingSetup(regs.lighting, g_state.lighting);
+    const auto& proctex_setup = GetProcTexSetup(regs.texturing, g_state.proctex);
 
     bool stencil_action_enable =
         g_state.regs.framebuffer.output_merger.stencil_test.enable &&
@@ -272,6 +301,15 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             // Clamp the result
             depth = std::clamp(depth, 0.0f, 1.0f);
 
+            // Skip texturing and shading for fragments that will fail the depth test anyway
+            if (early_depth_test) {
+                unsigned num_bits =
+                    FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
+                u32 z = (u32)(depth * ((1 << num_bits) - 1));
+                if (EarlyDepthTestFails(x >> 4, y >> 4, x >> 4, y >> 4, z, z))
+                    continue;
+            }
+
             // Perspective correct attribute interpolation:
             // Attribute values cannot be calculated by simple linear interpolation since
             // they are not linear in screen space. For example, when interpolating a
@@ -433,8 +471,8 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             // sample procedural texture
             if (regs.texturing.main_config.texture3_enable) {
                 const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
-                texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
+                texture_color[3] =
+                    ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(), proctex_setup);
             }
 
             // Texture environment - consists of 6 stages of color and alpha combining.
@@ -472,7 +510,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
                 };
                 std::tie(primary_fragment_color, secondary_fragment_color) = ComputeFragmentsColors(
-                    g_state.regs.lighting, g_state.lighting, normquat, view, texture_color);
+                    g_state.regs.lighting, lighting_setup, normquat, view, texture_color);
             }
 
             for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();